@@ -0,0 +1,85 @@
+#ifndef HIT_RATIO_CURVE_H
+#define HIT_RATIO_CURVE_H
+
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include "request.h"
+
+/*
+  HitRatioCurve: hit statistics over a grid of cache sizes
+
+  Implementations are fed one request at a time. When fed a sample of
+  the trace (see ShardsSampler), the sampling rate is set via setRate:
+  each sampled request then stands for 1/rate requests, and cache sizes
+  are scaled down to match.
+*/
+class HitRatioCurve
+{
+protected:
+    // cache sizes in ascending order
+    std::vector<uint64_t> _capacities;
+    // current sampling rate
+    double _rate;
+
+    // statistics, weighted by 1/rate at the time of each request
+    double _reqs;
+    double _bytes;
+    std::vector<double> _hits;
+    std::vector<double> _hitBytes;
+
+    void recordRequest(uint64_t size) {
+        _reqs += 1.0 / _rate;
+        _bytes += size / _rate;
+    }
+    void recordHit(size_t i, uint64_t size) {
+        _hits[i] += 1.0 / _rate;
+        _hitBytes[i] += size / _rate;
+    }
+
+public:
+    HitRatioCurve(const std::vector<uint64_t>& capacities)
+        : _capacities(capacities),
+          _rate(1.0),
+          _reqs(0),
+          _bytes(0)
+    {
+        std::sort(_capacities.begin(), _capacities.end());
+        _capacities.erase(std::unique(_capacities.begin(), _capacities.end()), _capacities.end());
+        _hits.assign(_capacities.size(), 0);
+        _hitBytes.assign(_capacities.size(), 0);
+    }
+    virtual ~HitRatioCurve()
+    {
+    }
+
+    // account a request to object (id, size) at time with ttl (0: none)
+    virtual void access(IdType id, uint64_t size, uint64_t time, uint64_t ttl) = 0;
+    // forget an object (e.g., if it leaves the sample)
+    virtual void erase(IdType id, uint64_t size) = 0;
+    // change the sampling rate for all following requests
+    virtual void setRate(double rate) {
+        _rate = rate;
+    }
+
+    const std::vector<uint64_t>& capacities() const {
+        return _capacities;
+    }
+    double rate() const {
+        return _rate;
+    }
+    double reqs() const {
+        return _reqs;
+    }
+    double bytes() const {
+        return _bytes;
+    }
+    double hits(size_t i) const {
+        return _hits[i];
+    }
+    double hitBytes(size_t i) const {
+        return _hitBytes[i];
+    }
+};
+
+#endif /* HIT_RATIO_CURVE_H */
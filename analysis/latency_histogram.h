@@ -0,0 +1,91 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <vector>
+#include <cstdint>
+
+/*
+  LatencyHistogram: log-linear histogram of latencies in nanoseconds
+
+  Values below 2^SUB_BITS get a bucket each, larger ones 2^SUB_BITS
+  buckets per power of two, so percentiles are accurate to within 1/16
+  in constant memory. Histograms of several threads can be merged.
+*/
+class LatencyHistogram
+{
+protected:
+    static const unsigned SUB_BITS = 4;
+    static const uint64_t SUB = uint64_t(1) << SUB_BITS;
+
+    std::vector<uint64_t> _counts;
+    uint64_t _count;
+    uint64_t _max;
+    double _sum;
+
+    static size_t bucket(uint64_t v) {
+        if (v < SUB) {
+            return v;
+        }
+        const unsigned msb = 63 - __builtin_clzll(v);
+        const unsigned shift = msb - SUB_BITS;
+        return ((shift + 1) << SUB_BITS) + ((v >> shift) & (SUB - 1));
+    }
+    // largest value in bucket b
+    static uint64_t upper(size_t b) {
+        if (b < SUB) {
+            return b;
+        }
+        const unsigned shift = b / SUB - 1;
+        return ((SUB + b % SUB + 1) << shift) - 1;
+    }
+
+public:
+    LatencyHistogram()
+        : _counts((64 - SUB_BITS + 1) * SUB, 0),
+          _count(0),
+          _max(0),
+          _sum(0)
+    {
+    }
+
+    void record(uint64_t ns) {
+        _counts[bucket(ns)]++;
+        _count++;
+        _max = ns > _max ? ns : _max;
+        _sum += ns;
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t b = 0; b < _counts.size(); b++) {
+            _counts[b] += other._counts[b];
+        }
+        _count += other._count;
+        _max = other._max > _max ? other._max : _max;
+        _sum += other._sum;
+    }
+
+    // latency below which a fraction p of the samples lie (bucket upper bound)
+    uint64_t percentile(double p) const {
+        const uint64_t rank = p * _count;
+        uint64_t seen = 0;
+        for (size_t b = 0; b < _counts.size(); b++) {
+            seen += _counts[b];
+            if (seen > rank) {
+                return upper(b) < _max ? upper(b) : _max;
+            }
+        }
+        return _max;
+    }
+
+    uint64_t count() const {
+        return _count;
+    }
+    uint64_t max() const {
+        return _max;
+    }
+    double mean() const {
+        return _count > 0 ? _sum / _count : 0;
+    }
+};
+
+#endif /* LATENCY_HISTOGRAM_H */
@@ -0,0 +1,54 @@
+#include <cmath>
+#include "policy_curve.h"
+
+PolicyCurve::PolicyCurve(const std::vector<uint64_t>& capacities, std::string cacheType,
+                         const std::vector<std::pair<std::string, std::string>>& params)
+    : HitRatioCurve(capacities),
+      _req(0, 0)
+{
+    for (size_t i = 0; i < _capacities.size(); i++) {
+        std::unique_ptr<Cache> cache = Cache::create_unique(cacheType);
+        if (cache == nullptr) {
+            _caches.clear();
+            return;
+        }
+        for (auto& par : params) {
+            cache->configure(par.first, par.second);
+        }
+        _caches.push_back(std::move(cache));
+    }
+    resize();
+}
+
+void PolicyCurve::resize()
+{
+    for (size_t i = 0; i < _caches.size(); i++) {
+        _caches[i]->setSize(llround(_capacities[i] * _rate));
+    }
+}
+
+void PolicyCurve::access(IdType id, uint64_t size, uint64_t time, uint64_t ttl)
+{
+    recordRequest(size);
+    _req.reinit(id, size, time, ttl);
+    for (size_t i = 0; i < _caches.size(); i++) {
+        _caches[i]->tick(&_req);
+        if (_caches[i]->access(&_req)) {
+            recordHit(i, size);
+        }
+    }
+}
+
+void PolicyCurve::erase(IdType id, uint64_t size)
+{
+    _req.reinit(id, size);
+    for (auto& cache : _caches) {
+        cache->evict(&_req);
+    }
+}
+
+void PolicyCurve::setRate(double rate)
+{
+    HitRatioCurve::setRate(rate);
+    resize();
+}
@@ -0,0 +1,40 @@
+#ifndef POLICY_CURVE_H
+#define POLICY_CURVE_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "cache.h"
+#include "hit_ratio_curve.h"
+
+/*
+  PolicyCurve: hit ratio curve of any registered Cache policy
+
+  Runs one cache instance per cache size. When fed a sample of the trace,
+  each instance is scaled down to rate * size bytes ("miniature
+  simulation").
+*/
+class PolicyCurve : public HitRatioCurve
+{
+protected:
+    std::vector<std::unique_ptr<Cache>> _caches;
+    SimpleRequest _req;
+
+    void resize();
+
+public:
+    PolicyCurve(const std::vector<uint64_t>& capacities, std::string cacheType,
+                const std::vector<std::pair<std::string, std::string>>& params);
+
+    // false if cacheType is not a registered policy
+    bool good() const {
+        return !_caches.empty();
+    }
+
+    virtual void access(IdType id, uint64_t size, uint64_t time, uint64_t ttl);
+    virtual void erase(IdType id, uint64_t size);
+    virtual void setRate(double rate);
+};
+
+#endif /* POLICY_CURVE_H */
@@ -0,0 +1,128 @@
+#include <cassert>
+#include <cmath>
+#include "shards.h"
+
+/*
+  ShardsSampler: spatial (hash-based) sampling of objects
+*/
+ShardsSampler::ShardsSampler(double rate, uint64_t maxObjects)
+    : _threshold(llround(rate * MODULUS)),
+      _maxObjects(maxObjects)
+{
+    assert(rate > 0 && rate <= 1);
+    if (_threshold == 0) {
+        _threshold = 1;
+    }
+}
+
+bool ShardsSampler::sample(uint64_t hash, IdType id, uint64_t size,
+                           const std::function<void(IdType, uint64_t)>& drop)
+{
+    hash &= MODULUS - 1;
+    if (hash >= _threshold) {
+        return false;
+    }
+    if (_maxObjects == 0) {
+        return true;
+    }
+    // fixed-size sampling: track distinct sampled objects
+    CacheObject obj(id, size);
+    if (_members.insert(obj).second) {
+        _heap.push(SampledObject{hash, obj});
+        while (_members.size() > _maxObjects) {
+            // lower the threshold to the largest sampled hash value
+            _threshold = _heap.top().hash;
+            while (!_heap.empty() && _heap.top().hash >= _threshold) {
+                const CacheObject dropped = _heap.top().obj;
+                _heap.pop();
+                _members.erase(dropped);
+                drop(dropped.id, dropped.size);
+            }
+        }
+    }
+    return hash < _threshold;
+}
+
+/*
+  ShardsEstimator: approximate hit ratio curves from a spatial sample
+*/
+ShardsEstimator::ShardsEstimator(double rate, uint64_t maxObjects, size_t groups,
+                                 const std::function<std::unique_ptr<HitRatioCurve>()>& makeCurve,
+                                 bool adjust)
+    : _sampler(rate, maxObjects),
+      _curve(makeCurve()),
+      _rate(_sampler.rate()),
+      _adjust(adjust),
+      _reqs(0),
+      _sampledReqs(0)
+{
+    _curve->setRate(_rate);
+    if (groups > 1) {
+        for (size_t g = 0; g < groups; g++) {
+            _groups.push_back(makeCurve());
+            _groups.back()->setRate(_rate / groups);
+        }
+    }
+}
+
+void ShardsEstimator::access(IdType id, uint64_t size, uint64_t time, uint64_t ttl)
+{
+    _reqs++;
+    // low hash bits decide the sample, high bits the sub-sample
+    const uint64_t hash = hash_mix(id);
+    const bool sampled = _sampler.sample(hash, id, size, [this](IdType did, uint64_t dsize) {
+            _curve->erase(did, dsize);
+            if (!_groups.empty()) {
+                _groups[(hash_mix(did) / ShardsSampler::MODULUS) % _groups.size()]->erase(did, dsize);
+            }
+        });
+    if (_sampler.rate() != _rate) {
+        _rate = _sampler.rate();
+        _curve->setRate(_rate);
+        for (auto& group : _groups) {
+            group->setRate(_rate / _groups.size());
+        }
+    }
+    if (!sampled) {
+        return;
+    }
+    _sampledReqs++;
+    _curve->access(id, size, time, ttl);
+    if (!_groups.empty()) {
+        _groups[(hash / ShardsSampler::MODULUS) % _groups.size()]->access(id, size, time, ttl);
+    }
+}
+
+double ShardsEstimator::objectHitRatio(const HitRatioCurve& curve, size_t i) const
+{
+    if (!_adjust || _sampler.fixedSize()) {
+        return curve.reqs() > 0 ? curve.hits(i) / curve.reqs() : 0;
+    }
+    // SHARDS_adj: attribute the surplus/deficit of sampled requests to hits
+    return _reqs > 0 ? (curve.hits(i) + _reqs - curve.reqs()) / _reqs : 0;
+}
+
+double ShardsEstimator::byteHitRatio(const HitRatioCurve& curve, size_t i) const
+{
+    // no adjustment: a single large (un)sampled object would shift it by whole percents
+    return curve.bytes() > 0 ? curve.hitBytes(i) / curve.bytes() : 0;
+}
+
+double ShardsEstimator::standardError(size_t i, bool bytes) const
+{
+    const size_t n = _groups.size();
+    if (n < 2) {
+        return 0;
+    }
+    double mean = 0;
+    for (auto& group : _groups) {
+        mean += bytes ? byteHitRatio(*group, i) : objectHitRatio(*group, i);
+    }
+    mean /= n;
+    double sq = 0;
+    for (auto& group : _groups) {
+        const double d = (bytes ? byteHitRatio(*group, i) : objectHitRatio(*group, i)) - mean;
+        sq += d * d;
+    }
+    return std::sqrt(sq / (n * (n - 1)));
+}
@@ -0,0 +1,133 @@
+#ifndef SHARDS_H
+#define SHARDS_H
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <unordered_set>
+#include <vector>
+#include "caches/cache_object.h"
+#include "hit_ratio_curve.h"
+
+/*
+  ShardsSampler: spatial (hash-based) sampling of objects
+
+  An object is in the sample iff hash(id) mod P < T, so all requests to
+  a sampled object are kept and the sampling rate is T/P. With a fixed
+  sample size, T is lowered whenever more than maxObjects distinct
+  objects are sampled, and the objects with the largest hash values are
+  dropped (SHARDS fixed-size variant).
+
+  Waldspurger et al. Efficient MRC Construction with SHARDS. FAST 2015.
+*/
+class ShardsSampler
+{
+public:
+    static const uint64_t MODULUS = 1ULL << 24;
+
+protected:
+    struct SampledObject
+    {
+        uint64_t hash;
+        CacheObject obj;
+
+        bool operator<(const SampledObject& rhs) const {
+            return hash < rhs.hash;
+        }
+    };
+
+    uint64_t _threshold;
+    // fixed-size sampling (0 = fixed-rate sampling)
+    uint64_t _maxObjects;
+    // sampled objects by hash value (fixed-size sampling only)
+    std::priority_queue<SampledObject> _heap;
+    std::unordered_set<CacheObject> _members;
+
+public:
+    ShardsSampler(double rate, uint64_t maxObjects);
+
+    // decide if a request with hash value hash (see hash_mix) is sampled;
+    // may lower the rate and call drop(id, size) for objects leaving the sample
+    bool sample(uint64_t hash, IdType id, uint64_t size,
+                const std::function<void(IdType, uint64_t)>& drop);
+
+    double rate() const {
+        return static_cast<double>(_threshold) / MODULUS;
+    }
+    bool fixedSize() const {
+        return _maxObjects > 0;
+    }
+};
+
+/*
+  ShardsEstimator: approximate hit ratio curves from a spatial sample
+
+  Feeds sampled requests into a HitRatioCurve (LRU stack distances or
+  miniature simulations of any policy). Hit ratios are the ratio of
+  sampled hits to sampled requests (or bytes). Optionally, fixed-rate
+  object hit ratios are corrected for the deviation of the number of
+  sampled requests from its expectation (SHARDS_adj); the correction is
+  off by default as it dominates when the scaled caches hold few objects.
+
+  The estimation error is reported as the standard error over G disjoint
+  sub-samples, each fed into its own curve at rate/G (replicated
+  sub-sampling). This doubles the cost, so it is optional (groups=0).
+  It measures the sampling variance of the estimator, not its bias.
+*/
+class ShardsEstimator
+{
+protected:
+    ShardsSampler _sampler;
+    std::unique_ptr<HitRatioCurve> _curve;
+    std::vector<std::unique_ptr<HitRatioCurve>> _groups;
+    double _rate;
+    // apply SHARDS_adj to fixed-rate object hit ratios
+    bool _adjust;
+
+    // totals over the whole (unsampled) trace
+    uint64_t _reqs;
+    uint64_t _sampledReqs;
+
+    double objectHitRatio(const HitRatioCurve& curve, size_t i) const;
+    double byteHitRatio(const HitRatioCurve& curve, size_t i) const;
+    double standardError(size_t i, bool bytes) const;
+
+public:
+    ShardsEstimator(double rate, uint64_t maxObjects, size_t groups,
+                    const std::function<std::unique_ptr<HitRatioCurve>()>& makeCurve,
+                    bool adjust = false);
+
+    void access(IdType id, uint64_t size, uint64_t time, uint64_t ttl);
+
+    const std::vector<uint64_t>& capacities() const {
+        return _curve->capacities();
+    }
+    // estimates (SHARDS_adj can push small-cache estimates below zero)
+    double objectHitRatio(size_t i) const {
+        return std::max(0.0, std::min(1.0, objectHitRatio(*_curve, i)));
+    }
+    double byteHitRatio(size_t i) const {
+        return std::max(0.0, std::min(1.0, byteHitRatio(*_curve, i)));
+    }
+    double objectHitRatioError(size_t i) const {
+        return standardError(i, false);
+    }
+    double byteHitRatioError(size_t i) const {
+        return standardError(i, true);
+    }
+    bool hasError() const {
+        return _groups.size() > 1;
+    }
+    double rate() const {
+        return _rate;
+    }
+    uint64_t reqs() const {
+        return _reqs;
+    }
+    uint64_t sampledReqs() const {
+        return _sampledReqs;
+    }
+};
+
+#endif /* SHARDS_H */
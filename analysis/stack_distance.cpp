@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cassert>
+#include "stack_distance.h"
+
+/*
+  Band: Fenwick tree over last-access times
+*/
+void LRUStackDistance::Band::add(size_t slot, int64_t delta)
+{
+    for (size_t i = slot; i < _tree.size(); i |= i + 1) {
+        _tree[i] += delta;
+    }
+}
+
+uint64_t LRUStackDistance::Band::prefix(size_t slot) const
+{
+    uint64_t sum = 0;
+    for (size_t i = slot; i > 0; i &= i - 1) {
+        sum += _tree[i - 1];
+    }
+    return sum;
+}
+
+void LRUStackDistance::Band::compact()
+{
+    // drop dead slots, keep at least half of the new capacity free
+    size_t live = 0;
+    for (size_t i = 0; i < _times.size(); i++) {
+        if (_sizes[i] > 0) {
+            _times[live] = _times[i];
+            _sizes[live] = _sizes[i];
+            live++;
+        }
+    }
+    assert(live == _live);
+    _times.resize(live);
+    _sizes.resize(live);
+    // rebuild the Fenwick tree in linear time
+    _tree.assign(std::max<size_t>(64, 2 * live), 0);
+    for (size_t i = 0; i < _tree.size(); i++) {
+        if (i < live) {
+            _tree[i] += _sizes[i];
+        }
+        const size_t parent = i | (i + 1);
+        if (parent < _tree.size()) {
+            _tree[parent] += _tree[i];
+        }
+    }
+}
+
+void LRUStackDistance::Band::append(uint64_t t, uint64_t size)
+{
+    assert(_times.empty() || _times.back() < t);
+    if (_times.size() == _tree.size()) {
+        compact();
+    }
+    const size_t slot = _times.size();
+    _times.push_back(t);
+    _sizes.push_back(size);
+    add(slot, size);
+    _live++;
+    _total += size;
+}
+
+void LRUStackDistance::Band::remove(uint64_t t)
+{
+    const size_t slot = std::lower_bound(_times.begin(), _times.end(), t) - _times.begin();
+    assert(slot < _times.size() && _times[slot] == t && _sizes[slot] > 0);
+    const uint64_t size = _sizes[slot];
+    add(slot, -static_cast<int64_t>(size));
+    _sizes[slot] = 0;
+    _live--;
+    _total -= size;
+}
+
+uint64_t LRUStackDistance::Band::after(uint64_t t) const
+{
+    const size_t slot = std::upper_bound(_times.begin(), _times.end(), t) - _times.begin();
+    return _total - prefix(slot);
+}
+
+/*
+  LRUStackDistance: one-pass byte-aware LRU hit ratio curve
+*/
+LRUStackDistance::LRUStackDistance(const std::vector<uint64_t>& capacities)
+    : HitRatioCurve(capacities),
+      _now(0)
+{
+    _bands.resize(_capacities.size());
+}
+
+void LRUStackDistance::access(IdType id, uint64_t size, uint64_t, uint64_t)
+{
+    recordRequest(size);
+    _now++;
+    // smallest capacity that can hold this object
+    const size_t band = std::lower_bound(_capacities.begin(), _capacities.end(), size) - _capacities.begin();
+    if (band == _capacities.size()) {
+        // never admitted at any capacity, does not occupy stack space
+        return;
+    }
+    CacheObject obj(id, size);
+    auto it = _lastAccess.find(obj);
+    if (it != _lastAccess.end()) {
+        const uint64_t last = it->second;
+        // stack distance at capacities[j] sums the bands 0..j
+        uint64_t others = 0;
+        for (size_t j = 0; j < _bands.size(); j++) {
+            if (!_bands[j].empty()) {
+                others += _bands[j].after(last);
+            }
+            const double distance = size + (_rate == 1.0 ? others : others / _rate);
+            if (distance > _capacities.back()) {
+                break;
+            }
+            if (j >= band && distance <= _capacities[j]) {
+                recordHit(j, size);
+            }
+        }
+        _bands[band].remove(last);
+        it->second = _now;
+    } else {
+        _lastAccess.emplace(obj, _now);
+    }
+    _bands[band].append(_now, size);
+}
+
+void LRUStackDistance::erase(IdType id, uint64_t size)
+{
+    CacheObject obj(id, size);
+    auto it = _lastAccess.find(obj);
+    if (it == _lastAccess.end()) {
+        return;
+    }
+    const size_t band = std::lower_bound(_capacities.begin(), _capacities.end(), size) - _capacities.begin();
+    _bands[band].remove(it->second);
+    _lastAccess.erase(it);
+}
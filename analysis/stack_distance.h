@@ -0,0 +1,89 @@
+#ifndef STACK_DISTANCE_H
+#define STACK_DISTANCE_H
+
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include "caches/cache_object.h"
+#include "hit_ratio_curve.h"
+
+/*
+  LRUStackDistance: one-pass byte-aware LRU hit ratio curve
+
+  Mattson-style stack analysis: a request to object x hits in an LRU
+  cache of capacity C iff the bytes of all distinct objects requested
+  since x's last request, plus x's own size, fit into C.
+
+  LRUCache never admits objects larger than its capacity, so such
+  objects do not take up stack space at that capacity (LRU with variable
+  object sizes is not a pure stack algorithm). To remain exact at every
+  configured capacity, objects are partitioned into size bands between
+  consecutive capacities, and each band keeps a Fenwick tree over the
+  last-access times of its objects. The stack distance at capacity C_j
+  then sums the bands up to j.
+
+  When fed a sample of the trace, the bytes of other objects in the
+  stack distance are scaled up by 1/rate (as in SHARDS).
+
+  [O(K log n) time per request for K capacities and n distinct objects]
+*/
+class LRUStackDistance : public HitRatioCurve
+{
+protected:
+    /*
+      Band: objects whose size falls between two consecutive capacities
+
+      Slots are appended in access-time order; a Fenwick tree over the
+      slots sums the sizes of live slots. Dead slots are compacted away
+      once the slot array is full.
+    */
+    class Band
+    {
+    protected:
+        std::vector<uint64_t> _times; // access time of each slot (ascending)
+        std::vector<uint64_t> _sizes; // size of each slot (0 if dead)
+        std::vector<uint64_t> _tree; // Fenwick tree over _sizes
+        uint64_t _live; // number of live slots
+        uint64_t _total; // sum of live sizes
+
+        void add(size_t slot, int64_t delta);
+        uint64_t prefix(size_t slot) const; // sum over [0, slot)
+        void compact();
+
+    public:
+        Band()
+            : _live(0),
+              _total(0)
+        {
+        }
+
+        // append an access at time t (must be larger than all earlier times)
+        void append(uint64_t t, uint64_t size);
+        // remove the access at time t
+        void remove(uint64_t t);
+        // sum of sizes of live accesses after time t
+        uint64_t after(uint64_t t) const;
+        bool empty() const {
+            return _live == 0;
+        }
+    };
+
+    // bands[j] holds objects with capacities[j-1] < size <= capacities[j]
+    std::vector<Band> _bands;
+    // last access time of each object that fits into the largest capacity
+    std::unordered_map<CacheObject, uint64_t> _lastAccess;
+    uint64_t _now;
+
+public:
+    LRUStackDistance(const std::vector<uint64_t>& capacities);
+
+    // LRU without expiration: time and ttl are ignored
+    virtual void access(IdType id, uint64_t size, uint64_t time, uint64_t ttl);
+    virtual void erase(IdType id, uint64_t size);
+
+    size_t objects() const {
+        return _lastAccess.size();
+    }
+};
+
+#endif /* STACK_DISTANCE_H */
@@ -0,0 +1,234 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include "window_metrics.h"
+
+/*
+  WindowMetrics: per-window time series of a cache replay
+*/
+WindowMetrics::Snapshot::Snapshot()
+    : reqs(0),
+      hits(0),
+      bytes(0),
+      hitBytes(0),
+      admitted(0),
+      admittedBytes(0),
+      evicted(0),
+      evictedBytes(0),
+      expired(0),
+      expiredBytes(0)
+{
+}
+
+WindowMetrics::Snapshot::Snapshot(const ReplayStats& stats, const Cache& cache)
+    : reqs(stats.reqs),
+      hits(stats.hits),
+      bytes(stats.bytes),
+      hitBytes(stats.hitBytes),
+      admitted(cache.getAdmittedObjects()),
+      admittedBytes(cache.getAdmittedBytes()),
+      evicted(cache.getEvictedObjects()),
+      evictedBytes(cache.getEvictedBytes()),
+      expired(cache.getExpiredObjects()),
+      expiredBytes(cache.getExpiredBytes())
+{
+}
+
+WindowMetrics::WindowMetrics()
+    : _json(false),
+      _window(1000000),
+      _windowTime(false),
+      _warmup(0),
+      _warmupTime(false),
+      _windows(0),
+      _origin(0),
+      _windowEnd(0),
+      _started(false),
+      _open(false),
+      _warm(true),
+      _lastTime(0)
+{
+}
+
+// a length in requests, or in trace-time seconds with an "s" suffix
+static void parseLength(const std::string& value, uint64_t& length, bool& time)
+{
+    time = !value.empty() && value.back() == 's';
+    length = std::stoull(time ? value.substr(0, value.size() - 1) : value);
+}
+
+bool WindowMetrics::setPar(std::string parName, std::string parValue) {
+    if(parName=="metrics") {
+        _path = parValue;
+        const size_t dot = _path.rfind('.');
+        _json = dot != std::string::npos && _path.substr(dot).find(".json") == 0;
+    } else if(parName=="format") {
+        if(parValue=="csv" || parValue=="jsonl") {
+            _json = parValue=="jsonl";
+        } else {
+            std::cerr << "unrecognized metrics format: " << parValue << std::endl;
+        }
+    } else if(parName=="window") {
+        parseLength(parValue, _window, _windowTime);
+        assert(_window > 0);
+    } else if(parName=="warmup") {
+        parseLength(parValue, _warmup, _warmupTime);
+        _warm = _warmup == 0;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool WindowMetrics::open()
+{
+    if (_path.empty()) {
+        return true;
+    }
+    _out.open(_path);
+    if (!_out) {
+        std::cerr << "cannot open metrics file " << _path << std::endl;
+        return false;
+    }
+    if (!_json) {
+        _out << "window,warmup,reqs,hits,hit_ratio,bytes,hit_bytes,byte_hit_ratio,"
+             << "admitted,admitted_bytes,rejected_bytes,evicted,evicted_bytes,"
+             << "expired,expired_bytes,occupancy,time\n";
+    }
+    return true;
+}
+
+bool WindowMetrics::windowDone(const TraceRecord* rec, uint64_t reqs) const
+{
+    return _windowTime ? rec->time >= _windowEnd : reqs >= _windowEnd;
+}
+
+bool WindowMetrics::warmupDone(const TraceRecord* rec, uint64_t reqs) const
+{
+    return _warmupTime ? rec->time >= _origin + _warmup : reqs >= _warmup;
+}
+
+const TraceRecord* WindowMetrics::boundary(const TraceRecord* begin, const TraceRecord* end, uint64_t reqs) const
+{
+    // limits in requests first, then scan for limits in trace time
+    uint64_t n = end - begin;
+    if (!_windowTime) {
+        n = std::min(n, _windowEnd - reqs);
+    }
+    if (!_warm && !_warmupTime) {
+        n = std::min(n, _warmup - reqs);
+    }
+    if (_windowTime || (!_warm && _warmupTime)) {
+        for (uint64_t i = 0; i < n; i++) {
+            if ((_windowTime && windowDone(begin + i, reqs + i)) || (!_warm && warmupDone(begin + i, reqs + i))) {
+                return begin + i;
+            }
+        }
+    }
+    return begin + n;
+}
+
+void WindowMetrics::write(const std::string& window, bool warmup, const Snapshot& from, const Snapshot& to, uint64_t occupancy)
+{
+    if (_path.empty()) {
+        return;
+    }
+    const uint64_t reqs = to.reqs - from.reqs;
+    const uint64_t hits = to.hits - from.hits;
+    const uint64_t bytes = to.bytes - from.bytes;
+    const uint64_t hitBytes = to.hitBytes - from.hitBytes;
+    const uint64_t admittedBytes = to.admittedBytes - from.admittedBytes;
+    // every admission follows a miss, so the other missed bytes were rejected
+    const uint64_t missBytes = bytes - hitBytes;
+    const uint64_t values[] = {
+        reqs, hits, bytes, hitBytes,
+        to.admitted - from.admitted, admittedBytes,
+        missBytes > admittedBytes ? missBytes - admittedBytes : 0,
+        to.evicted - from.evicted, to.evictedBytes - from.evictedBytes,
+        to.expired - from.expired, to.expiredBytes - from.expiredBytes,
+        occupancy, _lastTime
+    };
+    const double hitRatio = reqs > 0 ? double(hits) / reqs : 0;
+    const double byteHitRatio = bytes > 0 ? double(hitBytes) / bytes : 0;
+    if (_json) {
+        const bool total = window == "total";
+        _out << "{\"window\":" << (total ? "\"total\"" : window)
+             << ",\"warmup\":" << (warmup ? "true" : "false")
+             << ",\"reqs\":" << values[0] << ",\"hits\":" << values[1]
+             << ",\"hit_ratio\":" << hitRatio
+             << ",\"bytes\":" << values[2] << ",\"hit_bytes\":" << values[3]
+             << ",\"byte_hit_ratio\":" << byteHitRatio
+             << ",\"admitted\":" << values[4] << ",\"admitted_bytes\":" << values[5]
+             << ",\"rejected_bytes\":" << values[6]
+             << ",\"evicted\":" << values[7] << ",\"evicted_bytes\":" << values[8]
+             << ",\"expired\":" << values[9] << ",\"expired_bytes\":" << values[10]
+             << ",\"occupancy\":" << values[11] << ",\"time\":" << values[12] << "}\n";
+    } else {
+        _out << window << "," << (warmup ? 1 : 0) << ","
+             << values[0] << "," << values[1] << "," << hitRatio << ","
+             << values[2] << "," << values[3] << "," << byteHitRatio;
+        for (size_t i = 4; i < sizeof(values) / sizeof(values[0]); i++) {
+            _out << "," << values[i];
+        }
+        _out << "\n";
+    }
+}
+
+void WindowMetrics::close(const ReplayStats& stats, const Cache& cache)
+{
+    write(std::to_string(_windows++), !_warm, _start, Snapshot(stats, cache), cache.getCurrentSize());
+    _open = false;
+}
+
+void WindowMetrics::replay(const TraceRecord* begin, const TraceRecord* end, ReplayStats& stats,
+                           const Cache& cache, const ReplayFunction& replay)
+{
+    while (begin != end) {
+        if (!_started) {
+            _origin = begin->time;
+            _started = true;
+        }
+        const bool warmupEnds = !_warm && warmupDone(begin, stats.reqs);
+        if (_open && (warmupEnds || windowDone(begin, stats.reqs))) {
+            close(stats, cache);
+        }
+        if (warmupEnds) {
+            _warm = true;
+            _warmEnd = Snapshot(stats, cache);
+        }
+        if (!_open) {
+            // the window begin falls into
+            _start = Snapshot(stats, cache);
+            if (_windowTime) {
+                const uint64_t elapsed = begin->time > _origin ? begin->time - _origin : 0;
+                _windowEnd = _origin + (elapsed / _window + 1) * _window;
+            } else {
+                _windowEnd = stats.reqs + _window;
+            }
+            _open = true;
+        }
+        const TraceRecord* next = boundary(begin, end, stats.reqs);
+        replay(begin, next, stats);
+        _lastTime = next[-1].time;
+        begin = next;
+    }
+}
+
+ReplayStats WindowMetrics::finish(const ReplayStats& stats, const Cache& cache)
+{
+    if (_open) {
+        close(stats, cache);
+    }
+    if (!_warm) {
+        std::cerr << "warm-up covers the whole trace" << std::endl;
+        _warmEnd = Snapshot(stats, cache);
+    }
+    write("total", false, _warmEnd, Snapshot(stats, cache), cache.getCurrentSize());
+    _out.flush();
+    ReplayStats totals;
+    totals.reqs = stats.reqs - _warmEnd.reqs;
+    totals.hits = stats.hits - _warmEnd.hits;
+    totals.bytes = stats.bytes - _warmEnd.bytes;
+    totals.hitBytes = stats.hitBytes - _warmEnd.hitBytes;
+    return totals;
+}
@@ -0,0 +1,108 @@
+#ifndef WINDOW_METRICS_H
+#define WINDOW_METRICS_H
+
+#include <string>
+#include <fstream>
+#include <functional>
+#include "cache.h"
+
+// replays a range of trace records through a cache, accumulating into stats
+typedef std::function<void(const TraceRecord*, const TraceRecord*, ReplayStats&)> ReplayFunction;
+
+/*
+  WindowMetrics: per-window time series of a cache replay
+
+  Splits the replay into windows of a number of requests or of trace-time
+  seconds and writes one record per window to a CSV or JSON lines file:
+  requests and hits, requested and hit bytes, the object and byte hit
+  ratios, admissions, evictions and expirations, the bytes of misses not
+  admitted, and the bytes cached at the window's end.
+
+  Nothing is added to the per-request path: the trace is replayed in
+  pieces that end at window boundaries, and each window's values are the
+  differences of the cache's cumulative counters between two boundaries.
+
+  The first requests (or trace-time seconds) can be declared a warm-up:
+  their windows are marked as such, and they are excluded from the totals
+  (the last record, and the summary webcachesim prints).
+*/
+class WindowMetrics
+{
+protected:
+    // cumulative counters at a window boundary
+    struct Snapshot
+    {
+        uint64_t reqs;
+        uint64_t hits;
+        uint64_t bytes;
+        uint64_t hitBytes;
+        uint64_t admitted;
+        uint64_t admittedBytes;
+        uint64_t evicted;
+        uint64_t evictedBytes;
+        uint64_t expired;
+        uint64_t expiredBytes;
+
+        Snapshot();
+        Snapshot(const ReplayStats& stats, const Cache& cache);
+    };
+
+    std::string _path;
+    bool _json;
+    // window length and warm-up, in requests or in trace-time seconds
+    uint64_t _window;
+    bool _windowTime;
+    uint64_t _warmup;
+    bool _warmupTime;
+
+    std::ofstream _out;
+    uint64_t _windows;
+    uint64_t _origin; // time of the first request
+    // the current window: its start, and its end in requests or trace time
+    Snapshot _start;
+    uint64_t _windowEnd;
+    bool _started;
+    bool _open;
+    // the warm-up ended, at _warmEnd
+    bool _warm;
+    Snapshot _warmEnd;
+    uint64_t _lastTime;
+
+    // whether rec, the request after the first reqs, is past the window or the warm-up
+    bool windowDone(const TraceRecord* rec, uint64_t reqs) const;
+    bool warmupDone(const TraceRecord* rec, uint64_t reqs) const;
+    // first record in [begin, end) past the window or the warm-up, or end
+    const TraceRecord* boundary(const TraceRecord* begin, const TraceRecord* end, uint64_t reqs) const;
+    void write(const std::string& window, bool warmup, const Snapshot& from, const Snapshot& to, uint64_t occupancy);
+    void close(const ReplayStats& stats, const Cache& cache);
+
+public:
+    WindowMetrics();
+
+    // metrics parameters, returns false if parName is none of them
+    bool setPar(std::string parName, std::string parValue);
+    static bool isPar(const std::string& parName) {
+        return parName=="metrics" || parName=="format" || parName=="window" || parName=="warmup";
+    }
+    // whether windows are written or a warm-up is excluded
+    bool enabled() const {
+        return !_path.empty() || _warmup > 0;
+    }
+    // open the output file, false on errors
+    bool open();
+
+    // replay [begin, end) through replay, writing the windows it completes
+    void replay(const TraceRecord* begin, const TraceRecord* end, ReplayStats& stats,
+                const Cache& cache, const ReplayFunction& replay);
+    // write the last (partial) window and the totals, returns stats without the warm-up
+    ReplayStats finish(const ReplayStats& stats, const Cache& cache);
+    // bytes the cache expired and evicted after the warm-up (after finish)
+    uint64_t expiredBytes(const Cache& cache) const {
+        return cache.getExpiredBytes() - _warmEnd.expiredBytes;
+    }
+    uint64_t evictedBytes(const Cache& cache) const {
+        return cache.getEvictedBytes() - _warmEnd.evictedBytes;
+    }
+};
+
+#endif /* WINDOW_METRICS_H */
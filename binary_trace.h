@@ -0,0 +1,68 @@
+#ifndef BINARY_TRACE_H
+#define BINARY_TRACE_H
+
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+
+/*
+  Binary trace format
+
+  A binary trace is a fixed-size header followed by a flat array of
+  fixed-width records (host byte order, i.e., little endian on x86).
+  Records are 8-byte aligned so that a memory-mapped trace can be read
+  in place without copying or parsing.
+*/
+
+// magic string at the start of every binary trace
+static const char BINARY_TRACE_MAGIC[8] = {'W', 'C', 'S', 'T', 'R', 'A', 'C', 'E'};
+// bump whenever the header or record layout changes
+static const uint32_t BINARY_TRACE_VERSION = 2;
+
+// one request: same columns as the text format
+struct TraceRecord
+{
+    uint64_t time; // request time
+    uint64_t id; // request object id
+    uint64_t size; // request size in bytes
+    uint64_t ttl; // object time-to-live, 0 if none
+};
+
+// parse a text trace line "time id size [ttl]", returns false if malformed
+inline bool parseTraceLine(const char* line, TraceRecord& rec)
+{
+    char* end;
+    uint64_t* fields[] = {&rec.time, &rec.id, &rec.size};
+    for (uint64_t* field : fields) {
+        *field = std::strtoull(line, &end, 10);
+        if (end == line) {
+            return false;
+        }
+        line = end;
+    }
+    // optional ttl column
+    rec.ttl = std::strtoull(line, &end, 10);
+    return true;
+}
+
+struct BinaryTraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize; // sizeof(TraceRecord), guards against layout changes
+    uint64_t count; // number of records following the header
+
+    BinaryTraceHeader()
+        : version(BINARY_TRACE_VERSION),
+          recordSize(sizeof(TraceRecord)),
+          count(0)
+    {
+        std::memcpy(magic, BINARY_TRACE_MAGIC, sizeof(magic));
+    }
+
+    bool hasMagic() const {
+        return std::memcmp(magic, BINARY_TRACE_MAGIC, sizeof(magic)) == 0;
+    }
+};
+
+#endif /* BINARY_TRACE_H */
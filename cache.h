@@ -10,28 +10,32 @@
 #include <cstdint>
 #include <memory>
 #include "request.h"
+#include "binary_trace.h"
+#include "caches/cache_expiry.h"
+#include "instrumentation.h"
 
-// uncomment to enable cache debugging:
-// #define CDEBUG 1
-
-// util for debug
-#ifdef CDEBUG
-inline void logMessage(std::string m, double x, double y, double z) {
-    std::cerr << m << "," << x << "," << y  << "," << z << "\n";
-}
-#define LOG(m,x,y,z) logMessage(m,x,y,z)
-#else
-#define LOG(m,x,y,z)
-#endif
 
+class Cache;
+class ReplayEngine;
 
+/*
+  CacheListener: observes the objects a cache inserts and removes
 
-class Cache;
+  Called from within the policy's own admit/evict code, so a listener
+  must not call back into the cache.
+*/
+class CacheListener {
+public:
+    virtual ~CacheListener() {}
+    virtual void onAdmit(IdType id, uint64_t size) = 0;
+    virtual void onEvict(IdType id, uint64_t size) = 0;
+};
 
 class CacheFactory {
 public:
     CacheFactory() {}
     virtual std::unique_ptr<Cache> create_unique() = 0;
+    virtual std::unique_ptr<ReplayEngine> create_engine() = 0;
 };
 
 class Cache {
@@ -39,7 +43,14 @@ public:
     // create and destroy a cache
     Cache()
         : _cacheSize(0),
-          _currentSize(0)
+          _currentSize(0),
+          _expiring(false),
+          _admittedObjects(0),
+          _admittedBytes(0),
+          _evictedObjects(0),
+          _evictedBytes(0),
+          _expiredObjects(0),
+          _expiredBytes(0)
     {
     }
     virtual ~Cache(){};
@@ -49,6 +60,52 @@ public:
     virtual void admit(SimpleRequest* req) = 0;
     virtual void evict(SimpleRequest* req) = 0;
     virtual void evict() = 0;
+    // lookup req and admit it on a miss, returns true on a hit. Same result
+    // as lookup followed by admit, policies override it to probe each of
+    // their structures only once.
+    virtual bool access(SimpleRequest* req) {
+        if (lookup(req)) {
+            return true;
+        }
+        admit(req);
+        return false;
+    }
+    // hint that req is looked up soon, e.g., to prefetch its metadata
+    virtual void prefetch(const SimpleRequest* req) {}
+    // advance the time to req's, expiring objects whose TTL has passed.
+    // Replays call it before each access; it is a no-op until the first
+    // TTL is seen (see setTtl).
+    void tick(const SimpleRequest* req) {
+        INSTRUMENT_ENTER(_instrumentId);
+        if (_expiry != nullptr || req->getTtl() != 0) {
+            expire(req);
+        }
+    }
+
+    // access reqs[0..n) in order, exactly as one access per request would. Request i + PREFETCH_DISTANCE is
+    // prefetched while request i is processed, so the memory accesses of
+    // consecutive lookups overlap. Bit i of hits (n/64 words, rounded up)
+    // is set if request i hit.
+    void processBatch(SimpleRequest* reqs, size_t n, uint64_t* hits) {
+        for (size_t w = 0; w < (n + 63) / 64; w++) {
+            hits[w] = 0;
+        }
+        for (size_t i = 0; i < n && i < PREFETCH_DISTANCE; i++) {
+            prefetch(&reqs[i]);
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (i + PREFETCH_DISTANCE < n) {
+                prefetch(&reqs[i + PREFETCH_DISTANCE]);
+            }
+            tick(&reqs[i]);
+            if (access(&reqs[i])) {
+                hits[i / 64] |= uint64_t(1) << (i % 64);
+            }
+        }
+    }
+
+    // how many requests ahead batches and replays prefetch
+    static const size_t PREFETCH_DISTANCE = 8;
 
     // configure cache parameters
     virtual void setSize(uint64_t cs) {
@@ -58,6 +115,34 @@ public:
         }
     }
     virtual void setPar(std::string parName, std::string parValue) {}
+    // TTL of objects whose requests have none in the trace, 0: no expiration
+    void setTtl(uint64_t ttl) {
+        if (_expiry == nullptr) {
+            _expiry.reset(new CacheExpiry(0));
+        }
+        _expiry->setDefaultTtl(ttl);
+    }
+    // the listener is notified of every admission and eviction from now on
+    void addListener(CacheListener* listener) {
+        _listeners.push_back(listener);
+    }
+    // charge the policy's instrumentation events to name (see instrumentation.h)
+    void instrumentAs(const std::string& name) {
+        INSTRUMENT_POLICY(_instrumentId, name);
+    }
+#ifdef CINSTRUMENT
+    unsigned instrumentId() const {
+        return _instrumentId;
+    }
+#endif
+    // parameters of every cache (ttl), the others go to setPar
+    void configure(std::string parName, std::string parValue) {
+        if(parName=="ttl") {
+            setTtl(std::stoull(parValue));
+        } else {
+            setPar(parName, parValue);
+        }
+    }
 
     uint64_t getCurrentSize() const {
         return(_currentSize);
@@ -65,6 +150,49 @@ public:
     uint64_t getSize() const {
         return(_cacheSize);
     }
+    // whether objects can expire, i.e., a TTL was set or seen in the trace
+    bool hasExpiry() const {
+        return _expiry != nullptr;
+    }
+    // objects inserted
+    uint64_t getAdmittedObjects() const {
+        return _admittedObjects;
+    }
+    uint64_t getAdmittedBytes() const {
+        return _admittedBytes;
+    }
+    // objects removed to make room (or by evict calls), not counting expirations
+    uint64_t getEvictedObjects() const {
+        return _evictedObjects;
+    }
+    uint64_t getEvictedBytes() const {
+        return _evictedBytes;
+    }
+    // objects removed because their TTL passed
+    uint64_t getExpiredObjects() const {
+        return _expiredObjects;
+    }
+    uint64_t getExpiredBytes() const {
+        return _expiredBytes;
+    }
+    // whether the policy keeps metadata of objects no longer cached that
+    // getGhostMemory reports (e.g., ghost lists)
+    virtual bool hasGhosts() const {
+        return false;
+    }
+    // most bytes allocated at once for that metadata, 0 if none (yet)
+    virtual uint64_t getGhostMemory() const {
+        return 0;
+    }
+    // whether the policy consumes the trace's next references (see
+    // offline_variants.h), so it must see every request of the trace
+    virtual bool offline() const {
+        return false;
+    }
+    // the eviction being reported to listeners is an expiration
+    bool isExpiring() const {
+        return _expiring;
+    }
 
     // helper functions (factory pattern)
     static void registerType(std::string name, CacheFactory *factory) {
@@ -79,12 +207,71 @@ public:
         Cache_instance = move(get_factory_instance()[name]->create_unique());
         return Cache_instance;
     }
+    // replay engine, specialized: statically dispatched, otherwise: via virtual calls
+    static std::unique_ptr<ReplayEngine> create_engine(std::string name, bool specialized = true);
 
 protected:
     // basic cache properties
     uint64_t _cacheSize; // size of cache in bytes
     uint64_t _currentSize; // total size of objects in cache in bytes
 
+    // expiration, created on demand
+    std::unique_ptr<CacheExpiry> _expiry;
+    bool _expiring; // evictions are expirations
+    uint64_t _admittedObjects;
+    uint64_t _admittedBytes;
+    uint64_t _evictedObjects;
+    uint64_t _evictedBytes;
+    uint64_t _expiredObjects;
+    uint64_t _expiredBytes;
+    std::vector<CacheListener*> _listeners;
+#ifdef CINSTRUMENT
+    unsigned _instrumentId = 0;
+#endif
+
+    // policies report every object they insert and every object they remove
+    void admitted(IdType id, uint64_t size) {
+        _admittedObjects++;
+        _admittedBytes += size;
+        INSTRUMENT_ADMIT();
+        if (_expiry != nullptr) {
+            _expiry->admitted(id, size);
+        }
+        for (auto listener : _listeners) {
+            listener->onAdmit(id, size);
+        }
+    }
+    void evicted(IdType id, uint64_t size) {
+        INSTRUMENT_EVICT(size, _expiring);
+        if (_expiring) {
+            _expiredObjects++;
+            _expiredBytes += size;
+        } else {
+            _evictedObjects++;
+            _evictedBytes += size;
+        }
+        if (_expiry != nullptr) {
+            _expiry->evicted(id, size);
+        }
+        for (auto listener : _listeners) {
+            listener->onEvict(id, size);
+        }
+    }
+
+    void expire(const SimpleRequest* req) {
+        if (_expiry == nullptr) {
+            _expiry.reset(new CacheExpiry(req->getTime()));
+        }
+        _expiry->request(req, [this](IdType id, uint64_t size) {
+                SimpleRequest expired(id, size);
+                _expiring = true;
+                evict(&expired);
+                _expiring = false;
+                // in case the policy did not have it
+                _expiry->evicted(id, size);
+            });
+    }
+
     // helper functions (factory pattern)
     static std::map<std::string, CacheFactory *> &get_factory_instance() {
         static std::map<std::string, CacheFactory *> map_instance;
@@ -92,15 +279,138 @@ protected:
     }
 };
 
+// statistics of a trace replay
+struct ReplayStats {
+    uint64_t reqs;
+    uint64_t hits;
+    uint64_t bytes;
+    uint64_t hitBytes;
+
+    ReplayStats()
+        : reqs(0),
+          hits(0),
+          bytes(0),
+          hitBytes(0)
+    {
+    }
+};
+
+/*
+  ReplayEngine: replays chunks of requests through a cache
+
+  The dynamic engine calls the cache through the Cache interface, i.e.,
+  processBatch on batches of requests, which makes virtual prefetch and
+  access calls per request. The
+  specialized engine holds a policy of static type T and calls it
+  directly: where the engine is instantiated next to the policy's
+  definitions (see the "extern template" declarations in the policy
+  headers), the compiler inlines the whole hot path and resolves the
+  policy's virtual hooks statically.
+*/
+class ReplayEngine {
+public:
+    virtual ~ReplayEngine() {}
+    // the cache, e.g., for setSize and setPar
+    virtual Cache& cache() = 0;
+    virtual void replay(const TraceRecord* begin, const TraceRecord* end, ReplayStats& stats) = 0;
+};
+
+class DynamicReplayEngine : public ReplayEngine {
+protected:
+    static const long BATCH = 256;
+
+    std::unique_ptr<Cache> _cache;
+
+public:
+    DynamicReplayEngine(std::unique_ptr<Cache> cache)
+        : _cache(std::move(cache))
+    {
+    }
+
+    Cache& cache() {
+        return *_cache;
+    }
+    void replay(const TraceRecord* begin, const TraceRecord* end, ReplayStats& stats) {
+        SimpleRequest reqs[BATCH];
+        uint64_t hits[BATCH / 64];
+        while (begin != end) {
+            const size_t n = end - begin < BATCH ? end - begin : BATCH;
+            for (size_t i = 0; i < n; i++) {
+                reqs[i].reinit(begin[i].id, begin[i].size, begin[i].time, begin[i].ttl);
+            }
+            _cache->processBatch(reqs, n, hits);
+            for (size_t i = 0; i < n; i++) {
+                stats.reqs++;
+                stats.bytes += begin[i].size;
+                if (hits[i / 64] >> (i % 64) & 1) {
+                    stats.hits++;
+                    stats.hitBytes += begin[i].size;
+                }
+            }
+            begin += n;
+        }
+    }
+};
+
+template<class T>
+class StaticReplayEngine : public ReplayEngine {
+protected:
+    T _cache;
+
+public:
+    Cache& cache() {
+        return _cache;
+    }
+    void replay(const TraceRecord* begin, const TraceRecord* end, ReplayStats& stats) {
+        SimpleRequest req(0, 0);
+        for (const TraceRecord* rec = begin; rec != end; ++rec) {
+            if (size_t(end - rec) > Cache::PREFETCH_DISTANCE) {
+                req.reinit(rec[Cache::PREFETCH_DISTANCE].id, rec[Cache::PREFETCH_DISTANCE].size);
+                _cache.T::prefetch(&req);
+            }
+            stats.reqs++;
+            stats.bytes += rec->size;
+            req.reinit(rec->id, rec->size, rec->time, rec->ttl);
+            _cache.tick(&req);
+            // qualified calls bypass the vtable
+            if (_cache.T::access(&req)) {
+                stats.hits++;
+                stats.hitBytes += rec->size;
+            }
+        }
+    }
+};
+
 template<class T>
 class Factory : public CacheFactory {
+protected:
+    std::string _name;
+
 public:
-    Factory(std::string name) { Cache::registerType(name, this); }
+    Factory(std::string name) : _name(name) { Cache::registerType(name, this); }
     std::unique_ptr<Cache> create_unique() {
         std::unique_ptr<Cache> newT(new T);
+        newT->instrumentAs(_name);
+        return newT;
+    }
+    std::unique_ptr<ReplayEngine> create_engine() {
+        std::unique_ptr<ReplayEngine> newT(new StaticReplayEngine<T>);
+        newT->cache().instrumentAs(_name);
         return newT;
     }
 };
 
+inline std::unique_ptr<ReplayEngine> Cache::create_engine(std::string name, bool specialized) {
+    if(get_factory_instance().count(name) != 1) {
+        std::cerr << "unkown cacheType" << std::endl;
+        return nullptr;
+    }
+    if (specialized) {
+        return get_factory_instance()[name]->create_engine();
+    }
+    std::unique_ptr<ReplayEngine> engine(new DynamicReplayEngine(create_unique(name)));
+    return engine;
+}
+
 
 #endif /* CACHE_H */
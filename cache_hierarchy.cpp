@@ -0,0 +1,250 @@
+#include <iostream>
+#include "cache_hierarchy.h"
+#include "random_helper.h"
+
+/*
+  CacheHierarchy::Tier: one policy of the hierarchy
+*/
+CacheHierarchy::Tier::Tier(CacheHierarchy* owner, unsigned level, const std::string& type, std::unique_ptr<Cache> cache)
+    : _owner(owner),
+      _level(level),
+      _type(type),
+      _size(0),
+      _cache(std::move(cache)),
+      _fill(true),
+      _maxSize(0),
+      _probability(1)
+{
+    _cache->addListener(this);
+}
+
+bool CacheHierarchy::Tier::admissible(const SimpleRequest* req, Path path) const
+{
+    if (path != DEMOTE && !_fill) {
+        return false;
+    }
+    if (_maxSize != 0 && req->getSize() > _maxSize) {
+        return false;
+    }
+    return _probability >= 1
+        || std::uniform_real_distribution<double>(0, 1)(globalGenerator) < _probability;
+}
+
+void CacheHierarchy::Tier::onAdmit(IdType id, uint64_t size)
+{
+    _resident.insert(id, size, FlatTable<Resident>::hash(id, size), [](const std::vector<uint32_t>&) {});
+    _owner->admitted(_level, id, size);
+}
+
+void CacheHierarchy::Tier::onEvict(IdType id, uint64_t size)
+{
+    const uint32_t slot = _resident.find(id, size);
+    if (slot != FLAT_NPOS) {
+        _resident.erase(slot, [](uint32_t, uint32_t) {});
+    }
+    _owner->evicted(_level, id, size, _cache->isExpiring());
+}
+
+/*
+  CacheHierarchy: tiers of caches, e.g., DRAM in front of flash
+*/
+CacheHierarchy::CacheHierarchy()
+    : _exclusive(false),
+      _demote(true),
+      _path(NONE),
+      _target(0),
+      _admitted(false),
+      _moving(false),
+      _now(0)
+{
+}
+
+bool CacheHierarchy::addTier(const std::string& cacheType, uint64_t cacheSize)
+{
+    std::unique_ptr<Cache> cache = Cache::create_unique(cacheType);
+    if (cache == nullptr) {
+        return false;
+    }
+    // lower tiers only see the misses of the tiers above
+    if (cache->offline() && !_tiers.empty()) {
+        std::cerr << "offline policies can only be the first tier: " << cacheType << std::endl;
+        return false;
+    }
+    cache->setSize(cacheSize);
+    _tiers.emplace_back(new Tier(this, _tiers.size(), cacheType, std::move(cache)));
+    _tiers.back()->_size = cacheSize;
+    return true;
+}
+
+void CacheHierarchy::configure(const std::string& parName, const std::string& parValue)
+{
+    // tierN:name applies to tier N only
+    if (parName.compare(0, 4, "tier") == 0 && parName.find(':') != std::string::npos) {
+        const size_t colon = parName.find(':');
+        // tier number: a few decimal digits, 0 (invalid) otherwise
+        const std::string number = parName.substr(4, colon - 4);
+        const bool digits = !number.empty() && number.size() < 10
+            && number.find_first_not_of("0123456789") == std::string::npos;
+        const unsigned level = digits ? std::stoul(number) : 0;
+        if (level < 1 || level > _tiers.size()) {
+            std::cerr << "unrecognized tier: " << parName << std::endl;
+            return;
+        }
+        Tier& t = *_tiers[level - 1];
+        const std::string name = parName.substr(colon + 1);
+        if(name=="fill") {
+            t._fill = std::stoi(parValue) != 0;
+        } else if(name=="maxsize") {
+            t._maxSize = std::stoull(parValue);
+        } else if(name=="prob") {
+            t._probability = std::stod(parValue);
+        } else if(!t._device.setPar(name, parValue)) {
+            t._cache->configure(name, parValue);
+        }
+        return;
+    }
+    if(parName=="exclusive") {
+        _exclusive = std::stoi(parValue) != 0;
+    } else if(parName=="demote") {
+        _demote = std::stoi(parValue) != 0;
+    } else {
+        for (auto& t : _tiers) {
+            t->_cache->configure(parName, parValue);
+        }
+    }
+}
+
+bool CacheHierarchy::open()
+{
+    for (auto& t : _tiers) {
+        if (!t->_device.valid()) {
+            return false;
+        }
+        if (t->_device.enabled() && !t->_device.attach(*t->_cache, t->_size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int CacheHierarchy::access(SimpleRequest* req)
+{
+    _now = req->getTime();
+    for (auto& t : _tiers) {
+        t->_cache->tick(req);
+    }
+    int level = -1;
+    for (unsigned i = 0; i < _tiers.size(); i++) {
+        Tier& t = *_tiers[i];
+        INSTRUMENT_SCOPE(*t._cache);
+        t._stats.reqs++;
+        if (t._cache->lookup(req)) {
+            t._stats.hits++;
+            t._stats.hitBytes += req->getSize();
+            level = i;
+            break;
+        }
+    }
+    // fill the tiers above the hit
+    const unsigned above = level < 0 ? _tiers.size() : level;
+    const Path path = level < 0 ? FILL : PROMOTE;
+    for (unsigned i = 0; i < above; i++) {
+        if (admitTo(i, req, path) && _exclusive) {
+            if (level >= 0) {
+                // moved up: drop the lower copy without demoting it
+                INSTRUMENT_SCOPE(*_tiers[level]->_cache);
+                _moving = true;
+                _tiers[level]->_cache->evict(req);
+                _moving = false;
+            }
+            break;
+        }
+    }
+    settle();
+    return level;
+}
+
+void CacheHierarchy::replay(const TraceRecord* begin, const TraceRecord* end, ReplayStats& stats)
+{
+    SimpleRequest req;
+    for (const TraceRecord* r = begin; r != end; ++r) {
+        req.reinit(r->id, r->size, r->time, r->ttl);
+        stats.reqs++;
+        stats.bytes += r->size;
+        if (access(&req) >= 0) {
+            stats.hits++;
+            stats.hitBytes += r->size;
+        }
+    }
+}
+
+bool CacheHierarchy::admitTo(unsigned level, SimpleRequest* req, Path path)
+{
+    Tier& t = *_tiers[level];
+    if (!t.admissible(req, path)) {
+        return false;
+    }
+    _path = path;
+    _target = level;
+    _admitted = false;
+    INSTRUMENT_SCOPE(*t._cache);
+    t._cache->admit(req);
+    _path = NONE;
+    return _admitted;
+}
+
+void CacheHierarchy::admitted(unsigned level, IdType id, uint64_t size)
+{
+    if (_path == NONE || level != _target) {
+        return;
+    }
+    TierStats& s = _tiers[level]->_stats;
+    if (_path == FILL) {
+        s.fillBytes += size;
+    } else if (_path == PROMOTE) {
+        s.promotedBytes += size;
+    } else {
+        s.demotedBytes += size;
+    }
+    _admitted = true;
+}
+
+void CacheHierarchy::evicted(unsigned level, IdType id, uint64_t size, bool expired)
+{
+    _tiers[level]->_stats.evictedBytes += size;
+    if (_demote && !_moving && !expired && level + 1 < _tiers.size()) {
+        Demotion d;
+        d.level = level + 1;
+        d.id = id;
+        d.size = size;
+        _demotions.push_back(d);
+    }
+}
+
+void CacheHierarchy::settle()
+{
+    while (true) {
+        while (!_demotions.empty()) {
+            const Demotion d = _demotions.front();
+            _demotions.pop_front();
+            Tier& t = *_tiers[d.level];
+            if (t.contains(d.id, d.size)) {
+                continue;
+            }
+            // the demoted copy gets the default TTL from now on
+            SimpleRequest req(d.id, d.size, _now);
+            t._cache->tick(&req);
+            admitTo(d.level, &req, DEMOTE);
+        }
+        bool deferred = false;
+        for (auto& t : _tiers) {
+            if (t->_device.hasDeferred()) {
+                t->_device.applyDeferred();
+                deferred = true;
+            }
+        }
+        if (!deferred) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,162 @@
+#ifndef CACHE_HIERARCHY_H
+#define CACHE_HIERARCHY_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include "cache.h"
+#include "caches/flat_table.h"
+#include "flash/flash_device.h"
+
+// statistics of one tier of a CacheHierarchy
+struct TierStats {
+    uint64_t reqs; // requests that reached the tier
+    uint64_t hits;
+    uint64_t hitBytes;
+    uint64_t fillBytes; // admitted on a miss in all tiers
+    uint64_t promotedBytes; // admitted on a hit in a lower tier
+    uint64_t demotedBytes; // admitted when evicted from the tier above
+    uint64_t evictedBytes; // removed for capacity, expiration, or moves up
+
+    TierStats()
+        : reqs(0),
+          hits(0),
+          hitBytes(0),
+          fillBytes(0),
+          promotedBytes(0),
+          demotedBytes(0),
+          evictedBytes(0)
+    {
+    }
+};
+
+/*
+  CacheHierarchy: tiers of caches, e.g., DRAM in front of flash
+
+  Each tier is any registered policy. A request is looked up tier by tier
+  until one hits. The tiers above the hit (all tiers on a miss) are then
+  filled:
+
+  inclusive (default): every tier above admits a copy, lower tiers keep
+  theirs.
+  exclusive=1: only the first tier that admits the object gets it, and a
+  hit in a lower tier moves the object up.
+
+  With demote=1 (default), an object evicted (not expired) from a tier is
+  offered to the next tier, unless that tier still holds a copy. Every
+  admission is also subject to the tier's admission parameters
+  (tierN:fill, tierN:maxsize, tierN:prob) and to its policy's own
+  admission rule. A tier can sit on a simulated flash device
+  (tierN:device=..., see FlashDevice).
+
+  Each tier tracks which objects it holds through its policy's admitted
+  and evicted hooks, so demotions never re-admit cached objects. Moves
+  triggered by a tier's evictions are queued and run once the tier's
+  current call returned.
+*/
+class CacheHierarchy
+{
+protected:
+    struct Resident
+    {
+        IdType id;
+        uint64_t size;
+    };
+
+    enum Path {
+        NONE,
+        FILL,
+        PROMOTE,
+        DEMOTE
+    };
+
+    class Tier : public CacheListener
+    {
+    public:
+        CacheHierarchy* _owner;
+        unsigned _level;
+        std::string _type;
+        uint64_t _size;
+        std::unique_ptr<Cache> _cache;
+        FlashDevice _device;
+        FlatTable<Resident> _resident;
+        TierStats _stats;
+        // admission: fills and promotions allowed, size limit (0: none), probability
+        bool _fill;
+        uint64_t _maxSize;
+        double _probability;
+
+        Tier(CacheHierarchy* owner, unsigned level, const std::string& type, std::unique_ptr<Cache> cache);
+
+        bool contains(IdType id, uint64_t size) const {
+            return _resident.find(id, size) != FLAT_NPOS;
+        }
+        bool admissible(const SimpleRequest* req, Path path) const;
+        virtual void onAdmit(IdType id, uint64_t size);
+        virtual void onEvict(IdType id, uint64_t size);
+    };
+
+    struct Demotion
+    {
+        unsigned level;
+        IdType id;
+        uint64_t size;
+    };
+
+    std::vector<std::unique_ptr<Tier> > _tiers;
+    bool _exclusive;
+    bool _demote;
+
+    // the admission in progress and whether its tier admitted the object
+    Path _path;
+    unsigned _target;
+    bool _admitted;
+    // evictions that are moves up, not demotions
+    bool _moving;
+    std::deque<Demotion> _demotions;
+    // time of the current request
+    uint64_t _now;
+
+    bool admitTo(unsigned level, SimpleRequest* req, Path path);
+    void admitted(unsigned level, IdType id, uint64_t size);
+    void evicted(unsigned level, IdType id, uint64_t size, bool expired);
+    // run queued demotions and device evictions until none are left
+    void settle();
+
+public:
+    CacheHierarchy();
+
+    // one tier per call, top first, returns false for unknown types
+    bool addTier(const std::string& cacheType, uint64_t cacheSize);
+    // hierarchy parameters, tierN:name (N from 1) for one tier, and any
+    // other parameter for all tiers
+    void configure(const std::string& parName, const std::string& parValue);
+    // attach simulated flash devices, call after configure
+    bool open();
+
+    // serve req, returns the level that hit, -1 on a miss
+    int access(SimpleRequest* req);
+    void replay(const TraceRecord* begin, const TraceRecord* end, ReplayStats& stats);
+
+    unsigned tiers() const {
+        return _tiers.size();
+    }
+    const std::string& type(unsigned level) const {
+        return _tiers[level]->_type;
+    }
+    uint64_t size(unsigned level) const {
+        return _tiers[level]->_size;
+    }
+    const TierStats& stats(unsigned level) const {
+        return _tiers[level]->_stats;
+    }
+    Cache& cache(unsigned level) {
+        return *_tiers[level]->_cache;
+    }
+    const FlashDevice& device(unsigned level) const {
+        return _tiers[level]->_device;
+    }
+};
+
+#endif /* CACHE_HIERARCHY_H */
@@ -0,0 +1,130 @@
+#include <string>
+#include <regex>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <iostream>
+#include "caches/lru_variants.h"
+#include "caches/gd_variants.h"
+#include "caches/concurrent_cache.h"
+#include "analysis/latency_histogram.h"
+#include "random_helper.h"
+#include "request.h"
+#include "trace_reader.h"
+
+using namespace std;
+
+int main (int argc, char* argv[])
+{
+
+  // output help if insufficient params
+  if(argc < 4) {
+    cerr << "cachebench traceFile cacheType cacheSizeBytes [threads=n1,n2,...] [shards=n] [cacheParams]" << endl;
+    return 1;
+  }
+
+  // trace properties
+  const char* path = argv[1];
+  const string cacheType = argv[2];
+  const uint64_t cache_size  = std::stoull(argv[3]);
+
+  // parse benchmark and cache parameters
+  vector<unsigned> threadCounts = {1, 2, 4, 8};
+  unsigned shards = 64;
+  vector<pair<string, string> > cacheParams;
+  regex opexp ("(.*)=(.*)");
+  cmatch opmatch;
+  string paramSummary;
+  for(int i=4; i<argc; i++) {
+    regex_match (argv[i],opmatch,opexp);
+    if(opmatch.size()!=3) {
+      cerr << "each param needs to be in form name=value" << endl;
+      return 1;
+    }
+    const string parName = opmatch[1], parValue = opmatch[2];
+    if(parName=="threads") {
+      threadCounts.clear();
+      stringstream list(parValue);
+      string count;
+      while(getline(list, count, ','))
+        threadCounts.push_back(max(1ul, stoul(count)));
+    } else if(parName=="shards") {
+      shards = stoul(parValue);
+    } else {
+      cacheParams.push_back(make_pair(parName, parValue));
+      paramSummary += parValue;
+    }
+  }
+
+  // load the whole trace, so that reading it is not measured
+  unique_ptr<TraceReader> trace = TraceReader::open(path);
+  if(trace == nullptr)
+    return 1;
+  vector<TraceRecord> records;
+  const TraceRecord *begin, *end;
+  while (trace->nextChunk(begin, end))
+    records.insert(records.end(), begin, end);
+
+  cerr << "running..." << endl;
+
+  // one run per thread count, on a fresh cache; thread t replays requests
+  // t, t + n, t + 2n, ... so every thread sees the whole popularity mix
+  for(unsigned n : threadCounts) {
+    ConcurrentCache cache;
+    if(!cache.create(cacheType, cache_size, shards))
+      return 1;
+    for(auto& p : cacheParams)
+      cache.configure(p.first, p.second);
+
+    vector<LatencyHistogram> latency(n);
+    vector<uint64_t> hits(n, 0);
+    atomic<unsigned> ready(0);
+    atomic<bool> go(false);
+    vector<thread> threads;
+    for(unsigned t = 0; t < n; t++) {
+      threads.emplace_back([&, t]() {
+          seedGenerator();
+          SimpleRequest req;
+          LatencyHistogram local;
+          uint64_t localHits = 0;
+          ready++;
+          while(!go)
+            this_thread::yield();
+          for(size_t i = t; i < records.size(); i += n) {
+            const TraceRecord& r = records[i];
+            req.reinit(r.id, r.size, r.time, r.ttl);
+            const auto t0 = chrono::steady_clock::now();
+            localHits += cache.access(&req);
+            local.record(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count());
+          }
+          latency[t] = local;
+          hits[t] = localHits;
+        });
+    }
+    while(ready < n)
+      this_thread::yield();
+    const auto start = chrono::steady_clock::now();
+    go = true;
+    for(auto& th : threads)
+      th.join();
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    LatencyHistogram all;
+    uint64_t allHits = 0;
+    for(unsigned t = 0; t < n; t++) {
+      all.merge(latency[t]);
+      allHits += hits[t];
+    }
+    // threads, requests, hits, hit ratio, seconds, Mops/s, and the
+    // p50/p99/p99.9/max latency per operation in nanoseconds
+    cout << cacheType << " " << cache_size << " " << paramSummary << " "
+         << cache.shards() << " " << n << " "
+         << records.size() << " " << allHits << " " << double(allHits)/records.size() << " "
+         << seconds << " " << records.size()/seconds/1e6 << " "
+         << all.percentile(0.5) << " " << all.percentile(0.99) << " "
+         << all.percentile(0.999) << " " << all.max() << endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,235 @@
+#include <cmath>
+#include <cassert>
+#include "adaptsize.h"
+
+/*
+  AdaptSizeTuner: finds the admission parameter c of AdaptSize
+*/
+const double AdaptSizeTuner::EWMA_DECAY = 0.3;
+const size_t AdaptSizeTuner::MODEL_OBJECTS;
+
+double AdaptSizeTuner::modelHitRatio(const std::vector<Rate>& rates, double c, double cacheSize,
+                                     double horizon) const
+{
+    // expected bytes in cache at characteristic time T
+    std::vector<double> admission(rates.size());
+    for (size_t i = 0; i < rates.size(); i++) {
+        admission[i] = std::exp(-rates[i].size / c);
+    }
+    auto occupancy = [&](double T, double& hitRate) {
+        double bytes = 0;
+        hitRate = 0;
+        for (size_t i = 0; i < rates.size(); i++) {
+            const Rate& r = rates[i];
+            const double rT = r.rate * T;
+            const double p = admission[i];
+            // h = x p / (1 + x p), saturated once exp(rT) overflows
+            const double xp = rT > 700 ? HUGE_VAL : std::expm1(rT) * p;
+            const double h = p > 0 ? 1 / (1 + 1 / xp) : 0;
+            bytes += r.size * h;
+            hitRate += r.rate * h;
+        }
+        return bytes;
+    };
+    double totalRate = 0;
+    for (auto& r : rates) {
+        totalRate += r.rate;
+    }
+    if (totalRate == 0) {
+        return 0;
+    }
+    double hitRate;
+    // bisection on log T, occupancy grows with T. T is capped at the
+    // horizon the rates were measured over: otherwise a c that admits
+    // almost nothing leaves the cache empty, T grows without bound and
+    // every object is predicted to hit.
+    double lo = 0, hi = std::log(horizon);
+    if (occupancy(std::exp(hi), hitRate) <= cacheSize) {
+        return hitRate / totalRate;
+    }
+    for (int i = 0; i < 24; i++) {
+        const double mid = (lo + hi) / 2;
+        if (occupancy(std::exp(mid), hitRate) > cacheSize) {
+            hi = mid;
+        } else {
+            lo = mid;
+        }
+    }
+    occupancy(std::exp(lo), hitRate);
+    return hitRate / totalRate;
+}
+
+double AdaptSizeTuner::tune(const std::unordered_map<CacheObject, uint64_t>& window,
+                            uint64_t windowLength, uint64_t cacheSize)
+{
+    // age all objects, then add this window's counts
+    for (auto it = _ewma.begin(); it != _ewma.end(); ) {
+        it->second *= 1 - EWMA_DECAY;
+        if (it->second < 0.1 && window.count(it->first) == 0) {
+            it = _ewma.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto& w : window) {
+        _ewma[w.first] += EWMA_DECAY * w.second;
+    }
+
+    // the model runs on a spatial sample of at most MODEL_OBJECTS objects,
+    // picked by hash, against a cache scaled down by the same rate
+    const double sampling = std::min(1.0, double(MODEL_OBJECTS) / std::max<size_t>(_ewma.size(), 1));
+    const uint64_t threshold = sampling * double(uint64_t(1) << 32);
+    std::vector<Rate> rates;
+    rates.reserve(std::min<size_t>(_ewma.size(), 2 * MODEL_OBJECTS));
+    double maxSize = 1;
+    for (auto& e : _ewma) {
+        if ((object_hash(e.first.id, e.first.size) >> 32) >= threshold) {
+            continue;
+        }
+        Rate r;
+        r.size = e.first.size;
+        r.rate = e.second / windowLength;
+        rates.push_back(r);
+        maxSize = std::max(maxSize, r.size);
+    }
+
+    // coarse search over powers of two
+    const double sampledSize = sampling * cacheSize;
+    const double horizon = windowLength / EWMA_DECAY;
+    const int maxLog2 = std::ceil(std::log2(maxSize)) + 2;
+    double bestLog2 = 0, bestRatio = -1;
+    for (int x = 0; x <= maxLog2; x++) {
+        const double ratio = modelHitRatio(rates, std::pow(2.0, x), sampledSize, horizon);
+        if (ratio > bestRatio) {
+            bestRatio = ratio;
+            bestLog2 = x;
+        }
+    }
+    // golden section search around the best power of two
+    const double phi = (std::sqrt(5.0) - 1) / 2;
+    double a = bestLog2 - 1, b = bestLog2 + 1;
+    double x1 = b - phi * (b - a), x2 = a + phi * (b - a);
+    double f1 = modelHitRatio(rates, std::pow(2.0, x1), sampledSize, horizon);
+    double f2 = modelHitRatio(rates, std::pow(2.0, x2), sampledSize, horizon);
+    for (int i = 0; i < 10; i++) {
+        if (f1 > f2) {
+            b = x2;
+            x2 = x1;
+            f2 = f1;
+            x1 = b - phi * (b - a);
+            f1 = modelHitRatio(rates, std::pow(2.0, x1), sampledSize, horizon);
+        } else {
+            a = x1;
+            x1 = x2;
+            f1 = f2;
+            x2 = a + phi * (b - a);
+            f2 = modelHitRatio(rates, std::pow(2.0, x2), sampledSize, horizon);
+        }
+    }
+    const double refined = f1 > f2 ? x1 : x2;
+    return std::pow(2.0, std::max(f1, f2) > bestRatio ? refined : bestLog2);
+}
+
+/*
+  AdaptSize: ExpLRU admission with c tuned online
+*/
+AdaptSizeCache::AdaptSizeCache()
+    : ExpLRUCache(),
+      _windowLength(250000),
+      _windowRequests(0),
+      _jobCacheSize(0),
+      _jobPending(false),
+      _resultReady(false),
+      _result(0),
+      _stop(false)
+{
+}
+
+AdaptSizeCache::~AdaptSizeCache()
+{
+    if (_worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            _stop = true;
+        }
+        _signal.notify_all();
+        _worker.join();
+    }
+}
+
+void AdaptSizeCache::setPar(std::string parName, std::string parValue) {
+    if(parName=="w") {
+        const uint64_t w = std::stoull(parValue);
+        assert(w>0);
+        _windowLength = w;
+    } else {
+        // c: the initial c
+        ExpLRUCache::setPar(parName, parValue);
+    }
+}
+
+bool AdaptSizeCache::lookup(SimpleRequest* req)
+{
+    count(req);
+    return ExpLRUCache::lookup(req);
+}
+
+bool AdaptSizeCache::access(SimpleRequest* req)
+{
+    count(req);
+    return ExpLRUCache::access(req);
+}
+
+void AdaptSizeCache::count(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    _window[obj]++;
+    if (++_windowRequests == _windowLength) {
+        endWindow();
+    }
+}
+
+void AdaptSizeCache::endWindow()
+{
+    if (!_worker.joinable()) {
+        _worker = std::thread(&AdaptSizeCache::work, this);
+    }
+    std::unique_lock<std::mutex> guard(_lock);
+    // the previous window's tuning normally finished long ago
+    _signal.wait(guard, [this]() { return !_jobPending; });
+    if (_resultReady) {
+        _cParam = _result;
+        _resultReady = false;
+    }
+    _job.swap(_window);
+    _window.clear();
+    _jobCacheSize = _cacheSize;
+    _jobPending = true;
+    _windowRequests = 0;
+    guard.unlock();
+    _signal.notify_all();
+}
+
+void AdaptSizeCache::work()
+{
+    std::unique_lock<std::mutex> guard(_lock);
+    while (true) {
+        _signal.wait(guard, [this]() { return _jobPending || _stop; });
+        if (_stop) {
+            return;
+        }
+        // _job is not touched by the replay while _jobPending
+        guard.unlock();
+        const double c = _tuner.tune(_job, _windowLength, _jobCacheSize);
+        guard.lock();
+        _result = c;
+        _resultReady = true;
+        _jobPending = false;
+        _signal.notify_all();
+    }
+}
+
+/*
+  Statically dispatched replay engines
+*/
+template class StaticReplayEngine<AdaptSizeCache>;
@@ -0,0 +1,100 @@
+#ifndef ADAPTSIZE_H
+#define ADAPTSIZE_H
+
+#include <unordered_map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "cache.h"
+#include "cache_object.h"
+#include "lru_variants.h"
+
+/*
+  AdaptSizeTuner: finds the admission parameter c of AdaptSize
+
+  Keeps an exponentially weighted moving average of each object's
+  request count per window and picks the c that maximizes the object hit
+  ratio predicted by AdaptSize's Markov model of an LRU cache with
+  admission probability exp(-size/c) (Berger et al., NSDI'17): for each
+  candidate c, the characteristic time T solves
+    sum_i s_i h_i = cache size, h_i = x_i p_i / (1 + x_i p_i),
+    x_i = exp(r_i T) - 1, p_i = exp(-s_i/c),
+  and the predicted hit ratio is sum_i r_i h_i / sum_i r_i. Candidates
+  are powers of two, refined by a golden section search around the best.
+  With many distinct objects, the model runs on a hash-based sample of
+  them against a proportionally smaller cache.
+*/
+class AdaptSizeTuner
+{
+protected:
+    struct Rate
+    {
+        double size;
+        double rate; // requests per request
+    };
+
+    // EWMA of each object's requests per window
+    std::unordered_map<CacheObject, double> _ewma;
+
+    double modelHitRatio(const std::vector<Rate>& rates, double c, double cacheSize,
+                         double horizon) const;
+
+public:
+    // weight of the latest window in the moving average
+    static const double EWMA_DECAY;
+    // objects the model is evaluated on, larger windows are sampled
+    static const size_t MODEL_OBJECTS = 20000;
+
+    // fold in one window's request counts and return the best c
+    double tune(const std::unordered_map<CacheObject, uint64_t>& window,
+                uint64_t windowLength, uint64_t cacheSize);
+};
+
+/*
+  AdaptSize: ExpLRU admission with c tuned online
+
+  Request counts are collected per window of w requests. At each window
+  boundary the counts are handed to a background thread that solves for
+  the next c, so the replay does not wait for the optimization. The
+  result is applied at the following window boundary: the replay only
+  blocks if one tuning takes longer than replaying a whole window, and
+  results do not depend on thread timing.
+*/
+class AdaptSizeCache : public ExpLRUCache
+{
+protected:
+    uint64_t _windowLength;
+    uint64_t _windowRequests;
+    std::unordered_map<CacheObject, uint64_t> _window;
+
+    // worker thread and the tuning job it works on
+    AdaptSizeTuner _tuner;
+    std::thread _worker;
+    std::mutex _lock;
+    std::condition_variable _signal;
+    std::unordered_map<CacheObject, uint64_t> _job;
+    uint64_t _jobCacheSize;
+    bool _jobPending;
+    bool _resultReady;
+    double _result;
+    bool _stop;
+
+    void count(SimpleRequest* req);
+    // apply the previous window's result, start tuning on this window's counts
+    void endWindow();
+    void work();
+
+public:
+    AdaptSizeCache();
+    virtual ~AdaptSizeCache();
+
+    virtual void setPar(std::string parName, std::string parValue);
+    virtual bool lookup(SimpleRequest* req);
+    virtual bool access(SimpleRequest* req);
+};
+
+extern template class StaticReplayEngine<AdaptSizeCache>;
+static Factory<AdaptSizeCache> factoryAdaptSize("AdaptSize");
+
+#endif /* ADAPTSIZE_H */
@@ -0,0 +1,100 @@
+#ifndef ARC_GHOSTS_H
+#define ARC_GHOSTS_H
+
+#include <algorithm>
+#include "flat_lru.h"
+
+/*
+  ArcGhosts: the ghost lists B1 and B2 of ARC-style policies, and the
+  adaptive target size of T1 they drive
+
+  A ghost is the key of a recently evicted object: its id and size (the
+  size weighs the adaptation in bytes), in a 24-byte FlatLRUList slot
+  with no further state. Ghosts of objects evicted from T1 go to B1,
+  those of objects evicted from T2 go to B2. A ghost hit in B1 means T1
+  was too small and raises the target, one in B2 lowers it, by the
+  object's size times the ratio of the other list's bytes to this
+  list's (at least 1), so the target needs no tuning.
+
+  As in ARC, T1 and B1 take at most the cache size, and all four lists
+  at most twice the cache size; ghosts beyond that are dropped from the
+  least recent end of B1 or B2. Ghosts thus describe at most 2x the
+  cache size in bytes, and their memory is reported.
+*/
+class ArcGhosts
+{
+protected:
+    FlatLRUList _lists; // B1: list 0, B2: list 1
+    uint64_t _bytes[2];
+    uint64_t _target; // bytes T1 aims to take
+    uint64_t _peakMemory;
+
+    void drop(unsigned l) {
+        const uint32_t slot = _lists.back(l);
+        _bytes[l] -= _lists.size(slot);
+        _lists.erase(slot);
+    }
+
+public:
+    ArcGhosts()
+        : _target(0),
+          _peakMemory(0)
+    {
+        _lists.setLists(2);
+        _bytes[0] = _bytes[1] = 0;
+    }
+
+    // on a miss for (id, size) with hash h: remove its ghost and adapt the
+    // target, returns the ghost's list (0: B1, 1: B2) or -1 if none
+    int hit(IdType id, uint64_t size, uint64_t h, uint64_t cacheSize) {
+        const uint32_t slot = _lists.find(id, size, h);
+        if (slot == FLAT_NPOS) {
+            return -1;
+        }
+        const unsigned l = _lists.list(slot);
+        // _bytes[l] includes size, so it is 0 only for empty objects
+        const double ratio = _bytes[l] == 0 ? 1.0 : std::max(1.0, double(_bytes[1 - l]) / _bytes[l]);
+        const uint64_t delta = std::min(double(cacheSize), ratio * size);
+        if (l == 0) {
+            _target = std::min(_target + delta, cacheSize);
+        } else {
+            _target -= std::min(_target, delta);
+        }
+        _bytes[l] -= size;
+        _lists.erase(slot);
+        return l;
+    }
+
+    // remember (id, size), evicted from T1 (l = 0) or T2 (l = 1)
+    void add(IdType id, uint64_t size, unsigned l) {
+        _lists.pushFront(id, size, FlatLRUList::hash(id, size), l);
+        _bytes[l] += size;
+        _peakMemory = std::max(_peakMemory, _lists.memory());
+    }
+
+    // drop ghosts beyond the directory bounds, given the bytes in T1 and in T1 and T2
+    void trim(uint64_t t1Bytes, uint64_t residentBytes, uint64_t cacheSize) {
+        while (t1Bytes + _bytes[0] > cacheSize && _bytes[0] > 0) {
+            drop(0);
+        }
+        while (residentBytes + _bytes[0] + _bytes[1] > 2 * cacheSize) {
+            drop(_bytes[1] > 0 ? 1 : 0);
+        }
+    }
+
+    uint64_t target() const {
+        return _target;
+    }
+    uint64_t bytes(unsigned l) const {
+        return _bytes[l];
+    }
+    uint64_t count() const {
+        return _lists.count();
+    }
+    // most bytes allocated for ghosts so far
+    uint64_t peakMemory() const {
+        return _peakMemory;
+    }
+};
+
+#endif /* ARC_GHOSTS_H */
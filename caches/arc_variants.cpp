@@ -0,0 +1,255 @@
+#include "arc_variants.h"
+
+/*
+  ARC: Adaptive Replacement Cache (Megiddo and Modha, FAST'03)
+*/
+ARCCache::ARCCache()
+    : Cache()
+{
+    _cacheList.setLists(2);
+    _listSize[0] = _listSize[1] = 0;
+}
+
+bool ARCCache::lookup(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    return lookupHashed(obj, FlatLRUList::hash(obj.id, obj.size));
+}
+
+void ARCCache::admit(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    admitHashed(obj, FlatLRUList::hash(obj.id, obj.size));
+}
+
+bool ARCCache::access(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    const uint64_t h = FlatLRUList::hash(obj.id, obj.size);
+    if (lookupHashed(obj, h)) {
+        return true;
+    }
+    admitHashed(obj, h);
+    return false;
+}
+
+bool ARCCache::lookupHashed(const CacheObject& obj, uint64_t h)
+{
+    const uint32_t slot = _cacheList.find(obj.id, obj.size, h);
+    if (slot != FLAT_NPOS) {
+        if (_cacheList.list(slot) == 0) {
+            _listSize[0] -= obj.size;
+            _listSize[1] += obj.size;
+        }
+        _cacheList.moveToFront(slot, 1);
+        return true;
+    }
+    return false;
+}
+
+void ARCCache::admitHashed(const CacheObject& obj, uint64_t h)
+{
+    // object feasible to store?
+    if (obj.size > _cacheSize) {
+        INSTRUMENT_COUNT(BYPASSES);
+        return;
+    }
+    // requested again after its eviction: adapt, and admit it to T2
+    const int ghost = _ghosts.hit(obj.id, obj.size, h, _cacheSize);
+    // check eviction needed
+    while (_currentSize + obj.size > _cacheSize) {
+        replace(ghost == 1);
+    }
+    // admit new object
+    const unsigned l = ghost < 0 ? 0 : 1;
+    _cacheList.pushFront(obj.id, obj.size, h, l);
+    _listSize[l] += obj.size;
+    _currentSize += obj.size;
+    admitted(obj.id, obj.size);
+    _ghosts.trim(_listSize[0], _currentSize, _cacheSize);
+}
+
+void ARCCache::replace(bool ghostHit2)
+{
+    const uint64_t target = _ghosts.target();
+    const unsigned l = _listSize[0] > 0 && (_listSize[0] > target || (ghostHit2 && _listSize[0] == target) || _listSize[1] == 0) ? 0 : 1;
+    const uint32_t slot = _cacheList.back(l);
+    CacheObject obj(_cacheList.id(slot), _cacheList.size(slot));
+    _listSize[l] -= obj.size;
+    _currentSize -= obj.size;
+    _cacheList.erase(slot);
+    _ghosts.add(obj.id, obj.size, l);
+    evicted(obj.id, obj.size);
+}
+
+void ARCCache::evict(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    const uint32_t slot = _cacheList.find(obj.id, obj.size);
+    if (slot != FLAT_NPOS) {
+        _listSize[_cacheList.list(slot)] -= obj.size;
+        _currentSize -= obj.size;
+        _cacheList.erase(slot);
+        evicted(obj.id, obj.size);
+    }
+}
+
+void ARCCache::evict()
+{
+    if (_currentSize > 0) {
+        replace(false);
+        _ghosts.trim(_listSize[0], _currentSize, _cacheSize);
+    }
+}
+
+void ARCCache::prefetch(const SimpleRequest* req)
+{
+    _cacheList.prefetch(req->getId(), req->getSize());
+}
+
+uint64_t ARCCache::getGhostMemory() const
+{
+    return _ghosts.peakMemory();
+}
+
+/*
+  CAR: Clock with Adaptive Replacement (Bansal and Modha, FAST'04)
+*/
+CARCache::CARCache()
+    : Cache()
+{
+    _listSize[0] = _listSize[1] = 0;
+}
+
+bool CARCache::lookup(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    return lookupHashed(obj, FlatClock::hash(obj.id, obj.size));
+}
+
+void CARCache::admit(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    admitHashed(obj, FlatClock::hash(obj.id, obj.size));
+}
+
+bool CARCache::access(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    const uint64_t h = FlatClock::hash(obj.id, obj.size);
+    if (lookupHashed(obj, h)) {
+        return true;
+    }
+    admitHashed(obj, h);
+    return false;
+}
+
+bool CARCache::lookupHashed(const CacheObject& obj, uint64_t h)
+{
+    const uint32_t slot = _clock.find(obj.id, obj.size, h);
+    if (slot != FLAT_NPOS) {
+        _clock.flags(slot) |= VISITED;
+        return true;
+    }
+    return false;
+}
+
+void CARCache::admitHashed(const CacheObject& obj, uint64_t h)
+{
+    // object feasible to store?
+    if (obj.size > _cacheSize) {
+        INSTRUMENT_COUNT(BYPASSES);
+        return;
+    }
+    // requested again after its eviction: adapt, and admit it to T2
+    const int ghost = _ghosts.hit(obj.id, obj.size, h, _cacheSize);
+    // check eviction needed
+    while (_currentSize + obj.size > _cacheSize) {
+        replace();
+    }
+    // admit new object
+    const unsigned l = ghost < 0 ? 0 : 1;
+    _clock.pushBack(obj.id, obj.size, h, l == 0 ? 0 : IN_T2);
+    _listSize[l] += obj.size;
+    _currentSize += obj.size;
+    admitted(obj.id, obj.size);
+    _ghosts.trim(_listSize[0], _currentSize, _cacheSize);
+}
+
+uint32_t CARCache::oldest(unsigned l)
+{
+    // objects join a list at the back of the clock, so its hand only
+    // passes objects of the other list
+    while (true) {
+        const uint32_t slot = _clock.hand(l);
+        if (((_clock.flags(slot) & IN_T2) != 0) == (l == 1)) {
+            return slot;
+        }
+        INSTRUMENT_SCAN();
+        _clock.advance(l);
+    }
+}
+
+void CARCache::replace()
+{
+    while (true) {
+        const uint64_t t1 = _listSize[0];
+        const unsigned l = t1 > 0 && (t1 >= _ghosts.target() || _listSize[1] == 0) ? 0 : 1;
+        const uint32_t slot = oldest(l);
+        uint8_t& flags = _clock.flags(slot);
+        if (flags & VISITED) {
+            // referenced: to the back of T2
+            INSTRUMENT_SCAN();
+            flags = IN_T2;
+            if (l == 0) {
+                _listSize[0] -= _clock.size(slot);
+                _listSize[1] += _clock.size(slot);
+            }
+            _clock.moveToBack(slot);
+        } else {
+            CacheObject obj(_clock.id(slot), _clock.size(slot));
+            _listSize[l] -= obj.size;
+            _currentSize -= obj.size;
+            _clock.erase(slot);
+            _ghosts.add(obj.id, obj.size, l);
+            evicted(obj.id, obj.size);
+            return;
+        }
+    }
+}
+
+void CARCache::evict(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    const uint32_t slot = _clock.find(obj.id, obj.size);
+    if (slot != FLAT_NPOS) {
+        _listSize[(_clock.flags(slot) & IN_T2) ? 1 : 0] -= obj.size;
+        _currentSize -= obj.size;
+        _clock.erase(slot);
+        evicted(obj.id, obj.size);
+    }
+}
+
+void CARCache::evict()
+{
+    if (_currentSize > 0) {
+        replace();
+        _ghosts.trim(_listSize[0], _currentSize, _cacheSize);
+    }
+}
+
+void CARCache::prefetch(const SimpleRequest* req)
+{
+    _clock.prefetch(req->getId(), req->getSize());
+}
+
+uint64_t CARCache::getGhostMemory() const
+{
+    return _ghosts.peakMemory();
+}
+
+/*
+  Statically dispatched replay engines
+*/
+template class StaticReplayEngine<ARCCache>;
+template class StaticReplayEngine<CARCache>;
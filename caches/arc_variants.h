@@ -0,0 +1,103 @@
+#ifndef ARC_VARIANTS_H
+#define ARC_VARIANTS_H
+
+#include "cache.h"
+#include "cache_object.h"
+#include "flat_lru.h"
+#include "flat_clock.h"
+#include "arc_ghosts.h"
+
+/*
+  ARC: Adaptive Replacement Cache (Megiddo and Modha, FAST'03)
+
+  Objects requested once recently are in the recency list T1, objects
+  requested again in the frequency list T2, both in LRU order. Evicted
+  objects leave ghosts in B1 or B2, whose hits adapt the target size of
+  T1 (see ArcGhosts): an eviction takes the least recent object of T1 if
+  T1 exceeds its target, otherwise that of T2. Sizes are counted in bytes,
+  and there are no parameters.
+*/
+class ARCCache : public Cache
+{
+protected:
+    // T1: list 0, T2: list 1, with an embedded hash index
+    FlatLRUList _cacheList;
+    uint64_t _listSize[2];
+    ArcGhosts _ghosts;
+
+    bool lookupHashed(const CacheObject& obj, uint64_t h);
+    void admitHashed(const CacheObject& obj, uint64_t h);
+    // evict from T1 or T2 to B1 or B2, ghostHit2: the current miss hit a ghost in B2
+    void replace(bool ghostHit2);
+
+public:
+    ARCCache();
+    virtual ~ARCCache()
+    {
+    }
+
+    virtual bool lookup(SimpleRequest* req);
+    virtual void admit(SimpleRequest* req);
+    virtual void evict(SimpleRequest* req);
+    virtual void evict();
+    virtual bool access(SimpleRequest* req);
+    virtual void prefetch(const SimpleRequest* req);
+    virtual bool hasGhosts() const {
+        return true;
+    }
+    virtual uint64_t getGhostMemory() const;
+};
+
+extern template class StaticReplayEngine<ARCCache>;
+static Factory<ARCCache> factoryARC("ARC");
+
+/*
+  CAR: Clock with Adaptive Replacement (Bansal and Modha, FAST'04)
+
+  ARC with T1 and T2 as clocks: a hit only sets the object's reference
+  bit. T1's hand moves referenced objects to T2, T2's hand gives them a
+  second chance, and unreferenced objects are evicted to B1 or B2, whose
+  hits adapt T1's target as in ARC. Sizes are counted in bytes, and there
+  are no parameters.
+*/
+class CARCache : public Cache
+{
+protected:
+    // T1 and T2 interleaved in one clock, a hand for each
+    FlatClock _clock;
+    uint64_t _listSize[2];
+    ArcGhosts _ghosts;
+
+    // flag bits of a FlatClock entry
+    static const uint8_t VISITED = 1;
+    static const uint8_t IN_T2 = 2;
+
+    bool lookupHashed(const CacheObject& obj, uint64_t h);
+    void admitHashed(const CacheObject& obj, uint64_t h);
+    // oldest object of list l (0: T1, 1: T2), which must not be empty
+    uint32_t oldest(unsigned l);
+    // evict one object from T1 or T2 to B1 or B2
+    void replace();
+
+public:
+    CARCache();
+    virtual ~CARCache()
+    {
+    }
+
+    virtual bool lookup(SimpleRequest* req);
+    virtual void admit(SimpleRequest* req);
+    virtual void evict(SimpleRequest* req);
+    virtual void evict();
+    virtual bool access(SimpleRequest* req);
+    virtual void prefetch(const SimpleRequest* req);
+    virtual bool hasGhosts() const {
+        return true;
+    }
+    virtual uint64_t getGhostMemory() const;
+};
+
+extern template class StaticReplayEngine<CARCache>;
+static Factory<CARCache> factoryCAR("CAR");
+
+#endif /* ARC_VARIANTS_H */
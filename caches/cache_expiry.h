@@ -0,0 +1,93 @@
+#ifndef CACHE_EXPIRY_H
+#define CACHE_EXPIRY_H
+
+#include <algorithm>
+#include "request.h"
+#include "flat_table.h"
+#include "timing_wheel.h"
+
+/*
+  CacheExpiry: time-to-live bookkeeping of a cache
+
+  An object admitted while serving a request expires TTL time units after
+  that request: the request's own TTL (from the trace), or else the
+  default TTL (0: objects without a TTL in the trace do not expire).
+  Hits do not extend the TTL.
+
+  Each scheduled object's current due time is kept in a table, so timers
+  of objects that were evicted (and maybe admitted again) before their
+  due time are recognized as stale and ignored when they fire.
+*/
+class CacheExpiry
+{
+protected:
+    struct Entry
+    {
+        IdType id;
+        uint64_t size;
+        uint64_t due;
+    };
+
+    TimingWheel _wheel;
+    FlatTable<Entry> _due;
+    uint64_t _defaultTtl;
+    // due time of an object admitted for the current request, 0: none
+    uint64_t _pendingDue;
+
+public:
+    CacheExpiry(uint64_t now)
+        : _wheel(now),
+          _defaultTtl(0),
+          _pendingDue(0)
+    {
+    }
+
+    void setDefaultTtl(uint64_t ttl) {
+        _defaultTtl = ttl;
+    }
+
+    // advance to req's time, calling expire(id, size) for each object due
+    template<class F> void request(const SimpleRequest* req, F expire) {
+        _wheel.advance(req->getTime(), [this, &expire](const TimingWheel::Timer& t) {
+                const uint32_t slot = _due.find(t.id, t.size);
+                if (slot != FLAT_NPOS && _due[slot].due == t.due) {
+                    expire(t.id, t.size);
+                }
+            });
+        const uint64_t ttl = req->getTtl() != 0 ? req->getTtl() : _defaultTtl;
+        _pendingDue = 0;
+        if (ttl != 0) {
+            // request times may step back, timers are due after the wheel's time
+            _pendingDue = std::max(req->getTime() + ttl, _wheel.now() + 1);
+        }
+    }
+
+    // the cache admitted (id, size) for the current request
+    void admitted(IdType id, uint64_t size) {
+        if (_pendingDue == 0) {
+            return;
+        }
+        const uint64_t h = FlatTable<Entry>::hash(id, size);
+        uint32_t slot = _due.find(id, size, h);
+        if (slot == FLAT_NPOS) {
+            slot = _due.insert(id, size, h, [](const std::vector<uint32_t>&) {});
+        }
+        _due[slot].due = _pendingDue;
+        _wheel.schedule(id, size, _pendingDue);
+    }
+
+    // the cache evicted (id, size), for whatever reason
+    void evicted(IdType id, uint64_t size) {
+        const uint32_t slot = _due.find(id, size);
+        if (slot != FLAT_NPOS) {
+            _due.erase(slot, [](uint32_t, uint32_t) {});
+        }
+    }
+
+    // objects with a pending expiration
+    uint64_t scheduled() const {
+        return _due.size();
+    }
+};
+
+#endif /* CACHE_EXPIRY_H */
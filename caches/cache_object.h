@@ -14,6 +14,11 @@ struct CacheObject
           size(req->getSize())
     {}
 
+    CacheObject(IdType i, uint64_t s)
+        : id(i),
+          size(s)
+    {}
+
     // comparison is based on all three properties
     bool operator==(const CacheObject &rhs) const {
         return (rhs.id == id) && (rhs.size == size);
@@ -54,4 +59,23 @@ inline void hash_combine(std::size_t & seed, const T & v)
     seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
 }
 
+// 64-bit finalizer (from MurmurHash3's fmix64, public domain)
+// std::hash on integers is the identity in libstdc++, use this wherever
+// hash bits need to be uniformly distributed (sampling, open addressing)
+inline uint64_t hash_mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// well-mixed 64-bit hash of the object (id, size)
+inline uint64_t object_hash(IdType id, uint64_t size)
+{
+    return hash_mix(id ^ (size * 0x9e3779b97f4a7c15ULL));
+}
+
 #endif /* CACHE_HASH_H */
@@ -0,0 +1,312 @@
+#include <algorithm>
+#include "clock_variants.h"
+
+/*
+  CLOCK: second-chance FIFO eviction
+*/
+bool ClockCache::lookup(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    return lookupHashed(obj, FlatClock::hash(obj.id, obj.size));
+}
+
+void ClockCache::admit(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    admitHashed(obj, FlatClock::hash(obj.id, obj.size));
+}
+
+bool ClockCache::access(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    const uint64_t h = FlatClock::hash(obj.id, obj.size);
+    if (lookupHashed(obj, h)) {
+        return true;
+    }
+    admitHashed(obj, h);
+    return false;
+}
+
+bool ClockCache::lookupHashed(const CacheObject& obj, uint64_t h)
+{
+    const uint32_t slot = _clock.find(obj.id, obj.size, h);
+    if (slot != FLAT_NPOS) {
+        _clock.flags(slot) |= VISITED;
+        return true;
+    }
+    return false;
+}
+
+void ClockCache::admitHashed(const CacheObject& obj, uint64_t h)
+{
+    // object feasible to store?
+    if (obj.size > _cacheSize) {
+        INSTRUMENT_COUNT(BYPASSES);
+        return;
+    }
+    // check eviction needed
+    while (_currentSize + obj.size > _cacheSize) {
+        evict();
+    }
+    // admit new object
+    _clock.pushBack(obj.id, obj.size, h, 0);
+    _currentSize += obj.size;
+    admitted(obj.id, obj.size);
+}
+
+void ClockCache::remove(uint32_t slot)
+{
+    CacheObject obj(_clock.id(slot), _clock.size(slot));
+    _currentSize -= obj.size;
+    _clock.erase(slot);
+    evicted(obj.id, obj.size);
+}
+
+void ClockCache::evict(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    const uint32_t slot = _clock.find(obj.id, obj.size);
+    if (slot != FLAT_NPOS) {
+        remove(slot);
+    }
+}
+
+void ClockCache::evict()
+{
+    // oldest object without a reference bit, giving the others a second chance
+    while (!_clock.empty()) {
+        const uint32_t slot = _clock.front();
+        if (_clock.flags(slot) & VISITED) {
+            INSTRUMENT_SCAN();
+            _clock.flags(slot) &= ~VISITED;
+            _clock.moveToBack(slot);
+        } else {
+            remove(slot);
+            return;
+        }
+    }
+}
+
+void ClockCache::prefetch(const SimpleRequest* req)
+{
+    _clock.prefetch(req->getId(), req->getSize());
+}
+
+/*
+  SIEVE: lazy-promotion FIFO eviction
+*/
+void SieveCache::evict()
+{
+    // the hand rests on the next object once its object is removed
+    while (!_clock.empty()) {
+        const uint32_t slot = _clock.hand(0);
+        if (_clock.flags(slot) & VISITED) {
+            INSTRUMENT_SCAN();
+            _clock.flags(slot) &= ~VISITED;
+            _clock.advance(0);
+        } else {
+            remove(slot);
+            return;
+        }
+    }
+}
+
+/*
+  CLOCK-Pro: CLOCK with hot/cold classification by reuse distance
+*/
+ClockProCache::ClockProCache()
+    : ClockCache(),
+      _coldTarget(0),
+      _hotSize(0),
+      _ghostSize(0)
+{
+}
+
+bool ClockProCache::lookup(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    return lookupHashed(obj, FlatClock::hash(obj.id, obj.size));
+}
+
+void ClockProCache::admit(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    admitHashed(obj, FlatClock::hash(obj.id, obj.size));
+}
+
+bool ClockProCache::access(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    const uint64_t h = FlatClock::hash(obj.id, obj.size);
+    if (lookupHashed(obj, h)) {
+        return true;
+    }
+    admitHashed(obj, h);
+    return false;
+}
+
+bool ClockProCache::lookupHashed(const CacheObject& obj, uint64_t h)
+{
+    const uint32_t slot = _clock.find(obj.id, obj.size, h);
+    if (slot != FLAT_NPOS && !(_clock.flags(slot) & GHOST)) {
+        _clock.flags(slot) |= VISITED;
+        return true;
+    }
+    return false;
+}
+
+void ClockProCache::admitHashed(const CacheObject& obj, uint64_t h)
+{
+    // object feasible to store?
+    if (obj.size > _cacheSize) {
+        INSTRUMENT_COUNT(BYPASSES);
+        return;
+    }
+    // a ghost hit: reused within its test period, so admit it as hot
+    // and give cold objects more room
+    const uint32_t ghost = _clock.find(obj.id, obj.size, h);
+    const bool reused = ghost != FLAT_NPOS;
+    if (reused) {
+        _ghostSize -= obj.size;
+        _clock.erase(ghost);
+        _coldTarget = std::min(_coldTarget + obj.size, _cacheSize);
+    }
+    // check eviction needed
+    while (_currentSize + obj.size > _cacheSize) {
+        runHandCold();
+    }
+    // admit new object
+    _clock.pushBack(obj.id, obj.size, h, reused ? HOT : TEST);
+    _currentSize += obj.size;
+    admitted(obj.id, obj.size);
+    if (reused) {
+        _hotSize += obj.size;
+        while (_hotSize + _coldTarget > _cacheSize) {
+            runHandHot();
+        }
+    }
+}
+
+void ClockProCache::endTest(uint64_t size)
+{
+    _coldTarget -= std::min(_coldTarget, size);
+}
+
+void ClockProCache::runHandCold()
+{
+    while (true) {
+        if (_hotSize == _currentSize) {
+            runHandHot();
+        }
+        const uint32_t slot = _clock.hand(HAND_COLD);
+        uint8_t& flags = _clock.flags(slot);
+        if (flags & (HOT | GHOST)) {
+            INSTRUMENT_SCAN();
+            _clock.advance(HAND_COLD);
+        } else if (flags & VISITED) {
+            INSTRUMENT_SCAN();
+            // reused: a hot object if within its test period, otherwise a new test period
+            if (flags & TEST) {
+                flags = HOT;
+                _hotSize += _clock.size(slot);
+            } else {
+                flags = TEST;
+            }
+            _clock.moveToBack(slot);
+            while (_hotSize + _coldTarget > _cacheSize) {
+                runHandHot();
+            }
+        } else if (flags & TEST) {
+            // evicted within its test period, remembered as a ghost
+            const uint64_t size = _clock.size(slot);
+            flags = GHOST;
+            _currentSize -= size;
+            _ghostSize += size;
+            _clock.advance(HAND_COLD);
+            evicted(_clock.id(slot), size);
+            while (_ghostSize > _cacheSize) {
+                runHandTest();
+            }
+            return;
+        } else {
+            remove(slot);
+            return;
+        }
+    }
+}
+
+void ClockProCache::runHandHot()
+{
+    // the hot hand also ends the test periods it passes
+    while (true) {
+        INSTRUMENT_SCAN();
+        const uint32_t slot = _clock.hand(HAND_HOT);
+        uint8_t& flags = _clock.flags(slot);
+        if (flags & GHOST) {
+            _ghostSize -= _clock.size(slot);
+            endTest(_clock.size(slot));
+            _clock.erase(slot);
+        } else if (flags & HOT) {
+            _clock.advance(HAND_HOT);
+            if (flags & VISITED) {
+                flags &= ~VISITED;
+            } else {
+                flags = 0;
+                _hotSize -= _clock.size(slot);
+                return;
+            }
+        } else {
+            if (flags & TEST) {
+                flags &= ~TEST;
+                endTest(_clock.size(slot));
+            }
+            _clock.advance(HAND_HOT);
+        }
+    }
+}
+
+void ClockProCache::runHandTest()
+{
+    while (true) {
+        INSTRUMENT_SCAN();
+        const uint32_t slot = _clock.hand(HAND_TEST);
+        uint8_t& flags = _clock.flags(slot);
+        if (flags & GHOST) {
+            _ghostSize -= _clock.size(slot);
+            endTest(_clock.size(slot));
+            _clock.erase(slot);
+            return;
+        }
+        if (flags & TEST) {
+            flags &= ~TEST;
+            endTest(_clock.size(slot));
+        }
+        _clock.advance(HAND_TEST);
+    }
+}
+
+void ClockProCache::evict(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    const uint32_t slot = _clock.find(obj.id, obj.size);
+    if (slot != FLAT_NPOS && !(_clock.flags(slot) & GHOST)) {
+        if (_clock.flags(slot) & HOT) {
+            _hotSize -= obj.size;
+        }
+        remove(slot);
+    }
+}
+
+void ClockProCache::evict()
+{
+    if (_currentSize > 0) {
+        runHandCold();
+    }
+}
+
+/*
+  Statically dispatched replay engines
+*/
+template class StaticReplayEngine<ClockCache>;
+template class StaticReplayEngine<SieveCache>;
+template class StaticReplayEngine<ClockProCache>;
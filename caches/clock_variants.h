@@ -0,0 +1,134 @@
+#ifndef CLOCK_VARIANTS_H
+#define CLOCK_VARIANTS_H
+
+#include "cache.h"
+#include "cache_object.h"
+#include "flat_clock.h"
+
+/*
+  CLOCK: second-chance FIFO eviction
+
+  A hit only sets the object's reference bit. The oldest object is
+  evicted unless its bit is set, in which case the bit is cleared and the
+  object is reinserted as the newest one.
+*/
+class ClockCache : public Cache
+{
+protected:
+    // objects in insertion order, with an embedded hash index
+    FlatClock _clock;
+
+    // flag bits of a FlatClock entry
+    static const uint8_t VISITED = 1;
+
+    // lookup and admission given the object's hash h
+    bool lookupHashed(const CacheObject& obj, uint64_t h);
+    void admitHashed(const CacheObject& obj, uint64_t h);
+    // drop the resident object in slot and report its eviction
+    void remove(uint32_t slot);
+
+public:
+    ClockCache()
+        : Cache()
+    {
+    }
+    virtual ~ClockCache()
+    {
+    }
+
+    virtual bool lookup(SimpleRequest* req);
+    virtual void admit(SimpleRequest* req);
+    virtual void evict(SimpleRequest* req);
+    virtual void evict();
+    virtual bool access(SimpleRequest* req);
+    virtual void prefetch(const SimpleRequest* req);
+};
+
+extern template class StaticReplayEngine<ClockCache>;
+static Factory<ClockCache> factoryClock("CLOCK");
+
+/*
+  SIEVE: lazy-promotion FIFO eviction
+
+  Hits set the reference bit, as in CLOCK, but objects never move: a hand
+  sweeps from the oldest to the newest object (then wraps around),
+  clearing reference bits and evicting the first object without one in
+  place. New objects thus stay behind the hand for a whole sweep, while
+  surviving objects keep their age.
+*/
+class SieveCache : public ClockCache
+{
+public:
+    SieveCache()
+        : ClockCache()
+    {
+    }
+    virtual ~SieveCache()
+    {
+    }
+
+    virtual void evict();
+};
+
+extern template class StaticReplayEngine<SieveCache>;
+static Factory<SieveCache> factorySieve("SIEVE");
+
+/*
+  CLOCK-Pro: CLOCK with hot/cold classification by reuse distance
+
+  Resident objects are either hot or cold, and the clock also keeps
+  non-resident (ghost) entries of recently evicted cold objects. A cold
+  object starts a test period when it is admitted; a reuse within it
+  (while resident, or as a ghost hit) makes the object hot. Three hands
+  sweep the clock: the cold hand evicts cold objects, the hot hand demotes
+  hot objects without a reference bit, and the test hand ends test
+  periods, dropping ghosts so they take at most the cache size. The cold
+  space target adapts: ghost hits raise it, test periods ending without a
+  reuse lower it.
+
+  Sizes are counted in bytes, all other state is a flag byte per entry.
+*/
+class ClockProCache : public ClockCache
+{
+protected:
+    // flag bits, in addition to VISITED
+    static const uint8_t HOT = 2;
+    static const uint8_t TEST = 4;
+    static const uint8_t GHOST = 8;
+    // hands
+    static const unsigned HAND_COLD = 0;
+    static const unsigned HAND_HOT = 1;
+    static const unsigned HAND_TEST = 2;
+
+    uint64_t _coldTarget; // bytes the cold objects aim to take
+    uint64_t _hotSize; // bytes of hot objects
+    uint64_t _ghostSize; // bytes described by ghosts
+
+    bool lookupHashed(const CacheObject& obj, uint64_t h);
+    void admitHashed(const CacheObject& obj, uint64_t h);
+    // evict one cold object, demoting a hot one first if there is none
+    void runHandCold();
+    // demote one hot object
+    void runHandHot();
+    // drop one ghost
+    void runHandTest();
+    // a test period ended without a reuse
+    void endTest(uint64_t size);
+
+public:
+    ClockProCache();
+    virtual ~ClockProCache()
+    {
+    }
+
+    virtual bool lookup(SimpleRequest* req);
+    virtual void admit(SimpleRequest* req);
+    virtual void evict(SimpleRequest* req);
+    virtual void evict();
+    virtual bool access(SimpleRequest* req);
+};
+
+extern template class StaticReplayEngine<ClockProCache>;
+static Factory<ClockProCache> factoryClockPro("CLOCK-Pro");
+
+#endif /* CLOCK_VARIANTS_H */
@@ -0,0 +1,51 @@
+#include <iostream>
+#include "concurrent_cache.h"
+
+/*
+  ConcurrentCache: thread-safe cache made of independently locked shards
+*/
+ConcurrentCache::ConcurrentCache()
+    : _mask(0)
+{
+}
+
+bool ConcurrentCache::create(const std::string& cacheType, uint64_t cacheSize, unsigned shards)
+{
+    uint64_t n = 1;
+    while (n < shards) {
+        n *= 2;
+    }
+    _shards.clear();
+    for (uint64_t i = 0; i < n; i++) {
+        std::unique_ptr<Shard> s(new Shard());
+        s->cache = Cache::create_unique(cacheType);
+        if (s->cache == nullptr) {
+            return false;
+        }
+        // each shard only sees its part of the trace
+        if (s->cache->offline()) {
+            std::cerr << "offline policies cannot be sharded: " << cacheType << std::endl;
+            return false;
+        }
+        s->cache->setSize(cacheSize / n);
+        _shards.push_back(std::move(s));
+    }
+    _mask = n - 1;
+    return true;
+}
+
+void ConcurrentCache::configure(const std::string& parName, const std::string& parValue)
+{
+    for (auto& s : _shards) {
+        s->cache->configure(parName, parValue);
+    }
+}
+
+uint64_t ConcurrentCache::getCurrentSize() const
+{
+    uint64_t size = 0;
+    for (auto& s : _shards) {
+        size += s->cache->getCurrentSize();
+    }
+    return size;
+}
@@ -0,0 +1,85 @@
+#ifndef CONCURRENT_CACHE_H
+#define CONCURRENT_CACHE_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include "cache.h"
+
+/*
+  ConcurrentCache: thread-safe cache made of independently locked shards
+
+  Objects are partitioned by hash onto shards, each an instance of a
+  registered policy (e.g., LRU or GDSF) with its own lock and an equal
+  share of the capacity. Threads accessing different shards never
+  contend, so throughput scales with the thread count as long as the
+  shards outnumber the threads and no single object dominates.
+
+  Each shard makes its eviction decisions locally, so the hit ratio can
+  differ slightly from the unsharded policy's, more so with few objects
+  per shard.
+*/
+class ConcurrentCache
+{
+protected:
+    struct Shard
+    {
+        std::mutex lock;
+        std::unique_ptr<Cache> cache;
+        // keep the locks of neighboring shards on separate cache lines
+        char pad[64];
+    };
+
+    std::vector<std::unique_ptr<Shard> > _shards;
+    uint64_t _mask;
+
+    Shard& shard(const SimpleRequest* req) {
+        // high hash bits, the shard's table uses the low ones
+        return *_shards[(object_hash(req->getId(), req->getSize()) >> 40) & _mask];
+    }
+
+public:
+    ConcurrentCache();
+
+    // shards (rounded up to a power of two) of the policy cacheType,
+    // false for unknown types
+    bool create(const std::string& cacheType, uint64_t cacheSize, unsigned shards);
+    // configure every shard, call before the cache is shared
+    void configure(const std::string& parName, const std::string& parValue);
+
+    // thread-safe: serve req, returns true on a hit
+    bool access(SimpleRequest* req) {
+        Shard& s = shard(req);
+        std::lock_guard<std::mutex> guard(s.lock);
+        s.cache->tick(req);
+        return s.cache->access(req);
+    }
+    // thread-safe: lookup only
+    bool lookup(SimpleRequest* req) {
+        Shard& s = shard(req);
+        std::lock_guard<std::mutex> guard(s.lock);
+        return s.cache->lookup(req);
+    }
+    // thread-safe: admit (subject to the policy's admission)
+    void admit(SimpleRequest* req) {
+        Shard& s = shard(req);
+        std::lock_guard<std::mutex> guard(s.lock);
+        s.cache->tick(req);
+        s.cache->admit(req);
+    }
+    // thread-safe: remove req's object if cached
+    void evict(SimpleRequest* req) {
+        Shard& s = shard(req);
+        std::lock_guard<std::mutex> guard(s.lock);
+        s.cache->evict(req);
+    }
+
+    unsigned shards() const {
+        return _shards.size();
+    }
+    // bytes cached, not synchronized with concurrent accesses
+    uint64_t getCurrentSize() const;
+};
+
+#endif /* CONCURRENT_CACHE_H */
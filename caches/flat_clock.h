@@ -0,0 +1,203 @@
+#ifndef FLAT_CLOCK_H
+#define FLAT_CLOCK_H
+
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include "flat_table.h"
+
+// most clock hands a FlatClock can keep
+static const unsigned FLAT_CLOCK_MAX_HANDS = 3;
+
+/*
+  FlatClock: insertion-ordered ring of CacheObjects for CLOCK-style policies
+
+  Objects live in a FlatTable whose entries carry a flag byte (e.g., the
+  reference bit, which a hit sets without reordering anything) and their
+  position in a ring array. The ring holds the table slots in insertion
+  order, oldest first; objects enter at the back and can be moved to the
+  back again. Removing or moving an object leaves a hole in the ring,
+  which the hands skip; leading holes are dropped right away, and the ring
+  is compacted (or grown) once it is full.
+
+  Positions only increase, so they compare by age. Clock hands are kept
+  here (by number), as compaction renumbers the positions; a hand on a
+  hole stands for the next object, and a hand past the newest object
+  wraps around to the oldest one.
+*/
+class FlatClock
+{
+protected:
+    struct Entry
+    {
+        IdType id;
+        uint64_t size;
+        uint64_t pos; // in the ring
+        uint8_t flags;
+
+        Entry()
+            : id(0),
+              size(0),
+              pos(0),
+              flags(0)
+        {
+        }
+    };
+
+    FlatTable<Entry> _table;
+    std::vector<uint32_t> _ring; // slot per position, FLAT_NPOS: hole
+    uint64_t _mask;
+    uint64_t _head; // position of the oldest object
+    uint64_t _tail; // position after the newest object
+    uint64_t _holes;
+    uint64_t _hands[FLAT_CLOCK_MAX_HANDS];
+
+    uint32_t& at(uint64_t pos) {
+        return _ring[pos & _mask];
+    }
+    void trim() {
+        while (_head < _tail && at(_head) == FLAT_NPOS) {
+            _head++;
+            _holes--;
+        }
+    }
+    void hole(uint32_t slot) {
+        at(_table[slot].pos) = FLAT_NPOS;
+        _holes++;
+    }
+    // make room for one more position at the back
+    void reserve() {
+        if (_tail - _head < _ring.size()) {
+            return;
+        }
+        // compact in place of a ring at most half full, otherwise grow
+        const uint64_t live = _tail - _head - _holes;
+        const size_t capacity = 2 * live > _ring.size() ? 2 * _ring.size() : _ring.size();
+        std::vector<uint32_t> ring(capacity, FLAT_NPOS);
+        bool moved[FLAT_CLOCK_MAX_HANDS] = {false};
+        uint64_t n = 0;
+        for (uint64_t p = _head; p < _tail; p++) {
+            for (unsigned h = 0; h < FLAT_CLOCK_MAX_HANDS; h++) {
+                if (!moved[h] && _hands[h] <= p) {
+                    _hands[h] = n;
+                    moved[h] = true;
+                }
+            }
+            const uint32_t slot = at(p);
+            if (slot != FLAT_NPOS) {
+                ring[n] = slot;
+                _table[slot].pos = n;
+                n++;
+            }
+        }
+        for (unsigned h = 0; h < FLAT_CLOCK_MAX_HANDS; h++) {
+            _hands[h] = moved[h] ? _hands[h] : n;
+        }
+        _ring.swap(ring);
+        _mask = capacity - 1;
+        _head = 0;
+        _tail = n;
+        _holes = 0;
+    }
+
+public:
+    FlatClock()
+        : _ring(16, FLAT_NPOS),
+          _mask(15),
+          _head(0),
+          _tail(0),
+          _holes(0)
+    {
+        for (unsigned h = 0; h < FLAT_CLOCK_MAX_HANDS; h++) {
+            _hands[h] = 0;
+        }
+    }
+
+    static uint64_t hash(IdType id, uint64_t size) {
+        return FlatTable<Entry>::hash(id, size);
+    }
+
+    // slot of (id, size), FLAT_NPOS if not present
+    uint32_t find(IdType id, uint64_t size) const {
+        return _table.find(id, size);
+    }
+    uint32_t find(IdType id, uint64_t size, uint64_t h) const {
+        return _table.find(id, size, h);
+    }
+
+    void prefetch(IdType id, uint64_t size) const {
+        _table.prefetch(FlatTable<Entry>::hash(id, size));
+    }
+
+    // insert (id, size), which must not be present yet, as the newest object
+    uint32_t pushBack(IdType id, uint64_t size, uint64_t h, uint8_t flags) {
+        reserve();
+        const uint32_t slot = _table.insert(id, size, h, [this](const std::vector<uint32_t>& oldToNew) {
+                for (uint32_t i = 0; i < oldToNew.size(); i++) {
+                    if (oldToNew[i] != FLAT_NPOS) {
+                        at(_table[oldToNew[i]].pos) = oldToNew[i];
+                    }
+                }
+            });
+        Entry& e = _table[slot];
+        e.pos = _tail++;
+        e.flags = flags;
+        at(e.pos) = slot;
+        return slot;
+    }
+    // make slot's object the newest
+    void moveToBack(uint32_t slot) {
+        reserve();
+        hole(slot);
+        _table[slot].pos = _tail++;
+        at(_table[slot].pos) = slot;
+        trim();
+    }
+    void erase(uint32_t slot) {
+        hole(slot);
+        _table.erase(slot, [this](uint32_t from, uint32_t to) {
+                at(_table[to].pos) = to;
+            });
+        trim();
+    }
+
+    // slot of the object at or after hand h (wrapping), the clock must not be empty
+    uint32_t hand(unsigned h) {
+        assert(!empty());
+        uint64_t& p = _hands[h];
+        if (p < _head || p >= _tail) {
+            p = _head;
+        }
+        while (at(p) == FLAT_NPOS) {
+            p = p + 1 == _tail ? _head : p + 1;
+        }
+        return at(p);
+    }
+    // move hand h past its current object
+    void advance(unsigned h) {
+        _hands[h]++;
+    }
+
+    // slot of the oldest object, FLAT_NPOS if empty
+    uint32_t front() const {
+        return _head < _tail ? _ring[_head & _mask] : FLAT_NPOS;
+    }
+    bool empty() const {
+        return _table.size() == 0;
+    }
+    uint64_t objects() const {
+        return _table.size();
+    }
+
+    IdType id(uint32_t slot) const {
+        return _table[slot].id;
+    }
+    uint64_t size(uint32_t slot) const {
+        return _table[slot].size;
+    }
+    uint8_t& flags(uint32_t slot) {
+        return _table[slot].flags;
+    }
+};
+
+#endif /* FLAT_CLOCK_H */
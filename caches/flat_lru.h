@@ -0,0 +1,210 @@
+#ifndef FLAT_LRU_H
+#define FLAT_LRU_H
+
+#include "flat_table.h"
+
+// most recency lists a FlatLRUList can hold
+static const unsigned FLAT_LRU_MAX_LISTS = 16;
+
+/*
+  FlatLRUList: recency-ordered set of CacheObjects without heap nodes
+
+  The doubly-linked list is intrusive: each FlatTable slot embeds the
+  slot numbers of its list neighbors, so a lookup touches one slot and a
+  move-to-front rewrites a few links in the same array. A cached object
+  costs 24 bytes per slot (at a load factor of at most 0.7), compared to
+  a std::list node plus a std::unordered_map node before.
+
+  The table can also hold several recency lists (e.g., the segments of a
+  segmented LRU), so an object moves between lists without leaving its
+  slot. Each object's list number is then kept in a byte array parallel
+  to the slots; with a single list that array is not allocated.
+*/
+class FlatLRUList
+{
+protected:
+    struct Entry
+    {
+        IdType id;
+        uint64_t size;
+        uint32_t prev; // towards the front (most recent)
+        uint32_t next; // towards the back (least recent)
+
+        Entry()
+            : id(0),
+              size(0),
+              prev(FLAT_NPOS),
+              next(FLAT_NPOS)
+        {
+        }
+    };
+
+    FlatTable<Entry> _table;
+    uint32_t _front[FLAT_LRU_MAX_LISTS];
+    uint32_t _back[FLAT_LRU_MAX_LISTS];
+    unsigned _lists;
+    // list of each slot, empty if there is only one list
+    std::vector<uint8_t> _tags;
+
+    void unlink(uint32_t slot) {
+        Entry& e = _table[slot];
+        const unsigned l = list(slot);
+        if (e.prev != FLAT_NPOS) {
+            _table[e.prev].next = e.next;
+        } else {
+            _front[l] = e.next;
+        }
+        if (e.next != FLAT_NPOS) {
+            _table[e.next].prev = e.prev;
+        } else {
+            _back[l] = e.prev;
+        }
+    }
+
+    void linkFront(uint32_t slot, unsigned l) {
+        Entry& e = _table[slot];
+        e.prev = FLAT_NPOS;
+        e.next = _front[l];
+        if (_front[l] != FLAT_NPOS) {
+            _table[_front[l]].prev = slot;
+        } else {
+            _back[l] = slot;
+        }
+        _front[l] = slot;
+        if (!_tags.empty()) {
+            _tags[slot] = l;
+        }
+    }
+
+public:
+    FlatLRUList()
+        : _lists(1)
+    {
+        for (unsigned l = 0; l < FLAT_LRU_MAX_LISTS; l++) {
+            _front[l] = _back[l] = FLAT_NPOS;
+        }
+    }
+
+    // use lists recency lists, only while empty
+    void setLists(unsigned lists) {
+        assert(lists > 0 && lists <= FLAT_LRU_MAX_LISTS);
+        assert(empty());
+        _lists = lists;
+        _tags.assign(lists > 1 ? _table.capacity() : 0, 0);
+    }
+    unsigned lists() const {
+        return _lists;
+    }
+
+    static uint64_t hash(IdType id, uint64_t size) {
+        return FlatTable<Entry>::hash(id, size);
+    }
+
+    // slot of (id, size), FLAT_NPOS if not present
+    uint32_t find(IdType id, uint64_t size) const {
+        return _table.find(id, size);
+    }
+    uint32_t find(IdType id, uint64_t size, uint64_t h) const {
+        return _table.find(id, size, h);
+    }
+
+    void prefetch(IdType id, uint64_t size) const {
+        _table.prefetch(FlatTable<Entry>::hash(id, size));
+    }
+
+    // insert (id, size), which must not be present yet, as most recent of list l
+    uint32_t pushFront(IdType id, uint64_t size) {
+        return pushFront(id, size, FlatTable<Entry>::hash(id, size));
+    }
+    uint32_t pushFront(IdType id, uint64_t size, uint64_t h, unsigned l = 0) {
+        const uint32_t slot = _table.insert(id, size, h, [this](const std::vector<uint32_t>& oldToNew) {
+                // free slots have no links, so all slots can be remapped
+                for (uint32_t i = 0; i < _table.capacity(); i++) {
+                    Entry& e = _table[i];
+                    e.prev = e.prev == FLAT_NPOS ? FLAT_NPOS : oldToNew[e.prev];
+                    e.next = e.next == FLAT_NPOS ? FLAT_NPOS : oldToNew[e.next];
+                }
+                for (unsigned k = 0; k < _lists; k++) {
+                    _front[k] = _front[k] == FLAT_NPOS ? FLAT_NPOS : oldToNew[_front[k]];
+                    _back[k] = _back[k] == FLAT_NPOS ? FLAT_NPOS : oldToNew[_back[k]];
+                }
+                if (!_tags.empty()) {
+                    std::vector<uint8_t> tags(_table.capacity(), 0);
+                    for (uint32_t i = 0; i < oldToNew.size(); i++) {
+                        if (oldToNew[i] != FLAT_NPOS) {
+                            tags[oldToNew[i]] = _tags[i];
+                        }
+                    }
+                    _tags.swap(tags);
+                }
+            });
+        linkFront(slot, l);
+        return slot;
+    }
+
+    // make slot the most recent object of list l
+    void moveToFront(uint32_t slot, unsigned l = 0) {
+        if (slot != _front[l]) {
+            unlink(slot);
+            linkFront(slot, l);
+        }
+    }
+
+    void erase(uint32_t slot) {
+        unlink(slot);
+        _table.erase(slot, [this](uint32_t from, uint32_t to) {
+                // entry moved from "from" to "to": redirect its neighbors
+                if (!_tags.empty()) {
+                    _tags[to] = _tags[from];
+                }
+                const unsigned l = list(to);
+                Entry& e = _table[to];
+                if (e.prev != FLAT_NPOS) {
+                    _table[e.prev].next = to;
+                } else {
+                    _front[l] = to;
+                }
+                if (e.next != FLAT_NPOS) {
+                    _table[e.next].prev = to;
+                } else {
+                    _back[l] = to;
+                }
+            });
+    }
+
+    // least recent object of list l, FLAT_NPOS if empty
+    uint32_t back(unsigned l = 0) const {
+        return _back[l];
+    }
+    // most recent object of list l, FLAT_NPOS if empty
+    uint32_t front(unsigned l = 0) const {
+        return _front[l];
+    }
+    // the list slot is in
+    unsigned list(uint32_t slot) const {
+        return _tags.empty() ? 0 : _tags[slot];
+    }
+    // towards the front, FLAT_NPOS at the front
+    uint32_t prev(uint32_t slot) const {
+        return _table[slot].prev;
+    }
+
+    IdType id(uint32_t slot) const {
+        return _table[slot].id;
+    }
+    uint64_t size(uint32_t slot) const {
+        return _table[slot].size;
+    }
+    uint64_t count() const {
+        return _table.size();
+    }
+    bool empty() const {
+        return _table.size() == 0;
+    }
+    // bytes allocated for the slots and list numbers
+    uint64_t memory() const {
+        return _table.capacity() * sizeof(Entry) + _tags.size();
+    }
+};
+
+#endif /* FLAT_LRU_H */
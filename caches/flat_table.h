@@ -0,0 +1,164 @@
+#ifndef FLAT_TABLE_H
+#define FLAT_TABLE_H
+
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include "cache_object.h"
+#include "instrumentation.h"
+
+// slot number that denotes "no slot"
+static const uint32_t FLAT_NPOS = UINT32_MAX;
+
+/*
+  FlatTable: open-addressing hash table keyed by (id, size)
+
+  Entries live inline in one contiguous slot array (no per-object heap
+  allocation). Collisions are resolved by linear probing, and erase uses
+  backward-shift deletion, so there are no tombstones.
+
+  Slot numbers are stable except when entries move: on erase (reported
+  through onMove(from, to)) and on growth (reported through a remap array
+  from old to new slot numbers). Users that keep slot numbers, e.g., as
+  intrusive list links, fix them up in these callbacks.
+
+  Entry must have public members "IdType id" and "uint64_t size" and be
+  default constructible.
+*/
+template<class Entry>
+class FlatTable
+{
+protected:
+    static const IdType EMPTY_ID = UINT64_MAX;
+    static const uint64_t EMPTY_SIZE = UINT64_MAX;
+
+    std::vector<Entry> _slots;
+    uint64_t _mask;
+    uint64_t _count;
+
+    static bool isEmpty(const Entry& e) {
+        return e.id == EMPTY_ID && e.size == EMPTY_SIZE;
+    }
+    static void clear(Entry& e) {
+        e = Entry();
+        e.id = EMPTY_ID;
+        e.size = EMPTY_SIZE;
+    }
+
+    uint32_t home(uint64_t h) const {
+        return h & _mask;
+    }
+
+    // double the capacity, remap(oldToNew) is called once entries moved
+    template<class F> void grow(F remap) {
+        std::vector<Entry> old(2 * _slots.size());
+        old.swap(_slots);
+        _mask = _slots.size() - 1;
+        for (auto& e : _slots) {
+            clear(e);
+        }
+        std::vector<uint32_t> oldToNew(old.size(), FLAT_NPOS);
+        for (size_t i = 0; i < old.size(); i++) {
+            if (!isEmpty(old[i])) {
+                uint32_t j = home(hash(old[i].id, old[i].size));
+                while (!isEmpty(_slots[j])) {
+                    j = (j + 1) & _mask;
+                }
+                _slots[j] = old[i];
+                oldToNew[i] = j;
+            }
+        }
+        remap(oldToNew);
+    }
+
+public:
+    FlatTable(size_t initialCapacity = 1024)
+        : _count(0)
+    {
+        size_t cap = 16;
+        while (cap < initialCapacity) {
+            cap *= 2;
+        }
+        _slots.resize(cap);
+        for (auto& e : _slots) {
+            clear(e);
+        }
+        _mask = cap - 1;
+    }
+
+    static uint64_t hash(IdType id, uint64_t size) {
+        return object_hash(id, size);
+    }
+
+    // slot of (id, size), FLAT_NPOS if not found
+    uint32_t find(IdType id, uint64_t size) const {
+        return find(id, size, hash(id, size));
+    }
+    uint32_t find(IdType id, uint64_t size, uint64_t h) const {
+        for (uint32_t i = home(h); ; i = (i + 1) & _mask) {
+            const Entry& e = _slots[i];
+            if (e.id == id && e.size == size) {
+                INSTRUMENT_RECORD(PROBES, ((i - home(h)) & _mask) + 1);
+                return i;
+            }
+            if (isEmpty(e)) {
+                INSTRUMENT_RECORD(PROBES, ((i - home(h)) & _mask) + 1);
+                return FLAT_NPOS;
+            }
+        }
+    }
+
+    // pull the first probe slot of hash h into the CPU cache
+    void prefetch(uint64_t h) const {
+        __builtin_prefetch(&_slots[home(h)]);
+    }
+
+    // insert (id, size), which must not be present yet, returns its slot
+    template<class F> uint32_t insert(IdType id, uint64_t size, uint64_t h, F remap) {
+        assert(id != EMPTY_ID || size != EMPTY_SIZE);
+        // keep the load factor below 0.7
+        if (10 * (_count + 1) > 7 * _slots.size()) {
+            grow(remap);
+        }
+        uint32_t i = home(h);
+        while (!isEmpty(_slots[i])) {
+            i = (i + 1) & _mask;
+        }
+        _slots[i].id = id;
+        _slots[i].size = size;
+        _count++;
+        return i;
+    }
+
+    // erase the entry in slot, onMove(from, to) is called for each entry shifted back
+    template<class F> void erase(uint32_t slot, F onMove) {
+        assert(!isEmpty(_slots[slot]));
+        uint32_t hole = slot;
+        for (uint32_t i = (slot + 1) & _mask; !isEmpty(_slots[i]); i = (i + 1) & _mask) {
+            // move entry i into the hole unless its home lies cyclically in (hole, i]
+            const uint32_t h = home(hash(_slots[i].id, _slots[i].size));
+            if (((i - h) & _mask) >= ((i - hole) & _mask)) {
+                _slots[hole] = _slots[i];
+                onMove(i, hole);
+                hole = i;
+            }
+        }
+        clear(_slots[hole]);
+        _count--;
+    }
+
+    Entry& operator[](uint32_t slot) {
+        return _slots[slot];
+    }
+    const Entry& operator[](uint32_t slot) const {
+        return _slots[slot];
+    }
+    uint64_t size() const {
+        return _count;
+    }
+    uint64_t capacity() const {
+        return _slots.size();
+    }
+};
+
+#endif /* FLAT_TABLE_H */
@@ -6,89 +6,122 @@
   GD: greedy dual eviction (base class)
 */
 bool GreedyDualBase::lookup(SimpleRequest* req)
+{
+    return lookupHashed(req, IndexedHeap::hash(req->getId(), req->getSize()));
+}
+
+void GreedyDualBase::admit(SimpleRequest* req)
+{
+    admitHashed(req, IndexedHeap::hash(req->getId(), req->getSize()));
+}
+
+bool GreedyDualBase::access(SimpleRequest* req)
+{
+    const uint64_t h = IndexedHeap::hash(req->getId(), req->getSize());
+    if (lookupHashed(req, h)) {
+        return true;
+    }
+    admitHashed(req, h);
+    return false;
+}
+
+bool GreedyDualBase::lookupHashed(SimpleRequest* req, uint64_t h)
 {
     CacheObject obj(req);
-    auto it = _cacheMap.find(obj);
-    if (it != _cacheMap.end()) {
-        // log hit
-        LOG("h", 0, obj.id, obj.size);
-        hit(req);
+    const uint32_t slot = _valueHeap.find(obj.id, obj.size, h);
+    if (slot != FLAT_NPOS) {
+        hit(req, slot);
         return true;
     }
     return false;
 }
 
-void GreedyDualBase::admit(SimpleRequest* req)
+void GreedyDualBase::admitHashed(SimpleRequest* req, uint64_t h)
+{
+    CacheObject obj(req);
+    if (admissible(req) && makeRoom(obj)) {
+        // admit new object with new GF value
+        insert(obj, h, ageValue(req));
+    }
+}
+
+bool GreedyDualBase::admissible(SimpleRequest* req)
+{
+    return true;
+}
+
+bool GreedyDualBase::makeRoom(const CacheObject& obj)
 {
-    const uint64_t size = req->getSize();
     // object feasible to store?
-    if (size >= _cacheSize) {
-        LOG("error", _cacheSize, req->getId(), size);
-        return;
+    if (obj.size >= _cacheSize) {
+        INSTRUMENT_COUNT(BYPASSES);
+        return false;
     }
     // check eviction needed
-    while (_currentSize + size > _cacheSize) {
+    while (_currentSize + obj.size > _cacheSize) {
         evict();
     }
-    // admit new object with new GF value
-    long double ageVal = ageValue(req);
-    CacheObject obj(req);
-    LOG("a", ageVal, obj.id, obj.size);
-    _cacheMap[obj] = _valueMap.emplace(ageVal, obj);
-    _currentSize += size;
+    return true;
+}
+
+uint32_t GreedyDualBase::insert(const CacheObject& obj, uint64_t h, long double value)
+{
+    _currentSize += obj.size;
+    admitted(obj.id, obj.size);
+    return _valueHeap.push(obj.id, obj.size, value, h);
 }
 
 void GreedyDualBase::evict(SimpleRequest* req)
 {
     // evict the object match id, type, size of this request
     CacheObject obj(req);
-    auto it = _cacheMap.find(obj);
-    if (it != _cacheMap.end()) {
-        auto lit = it->second;
-        CacheObject toDelObj = it->first;
-        LOG("e", lit->first, toDelObj.id, toDelObj.size);
-        _currentSize -= toDelObj.size;
-        _valueMap.erase(lit);
-        _cacheMap.erase(it);
+    const uint32_t slot = _valueHeap.find(obj.id, obj.size);
+    if (slot != FLAT_NPOS) {
+        _currentSize -= obj.size;
+        evicted(obj.id, obj.size);
+        _valueHeap.erase(slot);
     }
 }
 
 void GreedyDualBase::evict()
 {
-    // evict first list element (smallest value)
-    if (_valueMap.size() > 0) {
-        ValueMapIteratorType lit  = _valueMap.begin();
-        if (lit == _valueMap.end()) {
-            std::cerr << "underun: " << _currentSize << ' ' << _cacheSize << std::endl;
-        }
-        assert(lit != _valueMap.end()); // bug if this happens
-        CacheObject toDelObj = lit->second;
-        LOG("e", lit->first, toDelObj.id, toDelObj.size);
+    // evict object with the smallest value
+    if (!_valueHeap.empty()) {
+        const uint32_t slot = _valueHeap.top();
+        CacheObject toDelObj(_valueHeap.id(slot), _valueHeap.size(slot));
         _currentSize -= toDelObj.size;
-        _cacheMap.erase(toDelObj);
+        evicted(toDelObj.id, toDelObj.size);
         // update L
-        _currentL = lit->first;
-        _valueMap.erase(lit);
+        _currentL = _valueHeap.value(slot);
+        _valueHeap.erase(slot);
     }
 }
 
+bool GreedyDualBase::nextVictim(IdType& id, uint64_t& size) const
+{
+    if (_valueHeap.empty()) {
+        return false;
+    }
+    id = _valueHeap.id(_valueHeap.top());
+    size = _valueHeap.size(_valueHeap.top());
+    return true;
+}
+
 long double GreedyDualBase::ageValue(SimpleRequest* req)
 {
     return _currentL + 1.0;
 }
 
-void GreedyDualBase::hit(SimpleRequest* req)
+void GreedyDualBase::hit(SimpleRequest* req, uint32_t slot)
 {
-    CacheObject obj(req);
-    // get iterator for the old position
-    auto it = _cacheMap.find(obj);
-    assert(it != _cacheMap.end());
-    CacheObject cachedObj = it->first;
-    ValueMapIteratorType si = it->second;
-    // update current req's value to hval:
-    _valueMap.erase(si);
+    // update current req's value to hval
     long double hval = ageValue(req);
-    it->second = _valueMap.emplace(hval, cachedObj);
+    _valueHeap.update(slot, hval);
+}
+
+void GreedyDualBase::prefetch(const SimpleRequest* req)
+{
+    _valueHeap.prefetch(req->getId(), req->getSize());
 }
 
 /*
@@ -101,24 +134,100 @@ long double GDSCache::ageValue(SimpleRequest* req)
 }
 
 /*
-  Greedy Dual Size Frequency policy
+  GD with request counts (base class of GDSF and LFUDA)
 */
-bool GDSFCache::lookup(SimpleRequest* req)
+void GDFrequencyBase::setPar(std::string parName, std::string parValue) {
+    if(parName=="ghost") {
+        _ghost.setCapacity(std::stoull(parValue));
+    } else {
+        std::cerr << "unrecognized parameter: " << parName << std::endl;
+    }
+}
+
+bool GDFrequencyBase::lookup(SimpleRequest* req)
 {
-    bool hit = GreedyDualBase::lookup(req);
     CacheObject obj(req);
-    if (!hit) {
-        _reqsMap[obj] = 1; //reset bec. reqs_map not updated when element removed
-    } else {
-        _reqsMap[obj]++;
+    const uint32_t slot = _valueHeap.find(obj.id, obj.size);
+    if (slot != FLAT_NPOS) {
+        countedHit(obj, slot);
+        return true;
     }
-    return hit;
+    return false;
+}
+
+void GDFrequencyBase::admit(SimpleRequest* req)
+{
+    countedMiss(req, IndexedHeap::hash(req->getId(), req->getSize()));
 }
 
-long double GDSFCache::ageValue(SimpleRequest* req)
+bool GDFrequencyBase::access(SimpleRequest* req)
 {
     CacheObject obj(req);
-    return _currentL + static_cast<double>(_reqsMap[obj]) / static_cast<double>(obj.size);
+    const uint64_t h = IndexedHeap::hash(obj.id, obj.size);
+    const uint32_t slot = _valueHeap.find(obj.id, obj.size, h);
+    if (slot != FLAT_NPOS) {
+        countedHit(obj, slot);
+        return true;
+    }
+    countedMiss(req, h);
+    return false;
+}
+
+void GDFrequencyBase::countedHit(const CacheObject& obj, uint32_t slot)
+{
+    uint64_t& count = _valueHeap.frequency(slot);
+    _valueHeap.update(slot, countValue(count, obj.size));
+    count++;
+}
+
+void GDFrequencyBase::countedMiss(SimpleRequest* req, uint64_t h)
+{
+    CacheObject obj(req);
+    // count restarts unless the ghost table remembers the object
+    uint64_t count = 0;
+    _ghost.take(obj.id, obj.size, count);
+    count++;
+    if (admissible(req) && makeRoom(obj)) {
+        const uint32_t slot = insert(obj, h, countValue(count, obj.size));
+        _valueHeap.frequency(slot) = count;
+    }
+}
+
+void GDFrequencyBase::retain(uint32_t slot)
+{
+    _ghost.insert(_valueHeap.id(slot), _valueHeap.size(slot), _valueHeap.frequency(slot));
+}
+
+void GDFrequencyBase::evict(SimpleRequest* req)
+{
+    const uint32_t slot = _valueHeap.find(req->getId(), req->getSize());
+    if (slot != FLAT_NPOS) {
+        retain(slot);
+    }
+    GreedyDualBase::evict(req);
+}
+
+void GDFrequencyBase::evict()
+{
+    if (!_valueHeap.empty()) {
+        retain(_valueHeap.top());
+    }
+    GreedyDualBase::evict();
+}
+
+long double GDFrequencyBase::ageValue(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    const uint32_t slot = _valueHeap.find(obj.id, obj.size);
+    return countValue(slot == FLAT_NPOS ? 1 : _valueHeap.frequency(slot), obj.size);
+}
+
+/*
+  Greedy Dual Size Frequency policy
+*/
+long double GDSFCache::countValue(uint64_t count, uint64_t size) const
+{
+    return _currentL + static_cast<double>(count) / static_cast<double>(size);
 }
 
 /*
@@ -127,82 +236,90 @@ long double GDSFCache::ageValue(SimpleRequest* req)
 LRUKCache::LRUKCache()
     : GreedyDualBase(),
       _tk(2),
-      _curTime(0)
+      _historyCapacity(0),
+      _rip(0),
+      _curTime(0),
+      _curSlot(FLAT_NPOS)
 {
 }
 
 void LRUKCache::setPar(std::string parName, std::string parValue) {
     if(parName=="k") {
         const int k = stoi(parValue);
-        assert(k>0);
+        assert(k>0 && k<=(int)LRUK_MAX_K);
         _tk = k;
+    } else if(parName=="history") {
+        _historyCapacity = std::stoull(parValue);
+    } else if(parName=="rip") {
+        _rip = std::stoull(parValue);
     } else {
         std::cerr << "unrecognized parameter: " << parName << std::endl;
+        return;
     }
+    _history.configure(_tk, _historyCapacity, _rip);
 }
 
 
 bool LRUKCache::lookup(SimpleRequest* req)
 {
-    CacheObject obj(req);
-    _curTime++;
-    _refsMap[obj].push(_curTime);
+    _curSlot = _history.reference(req->getId(), req->getSize(), ++_curTime);
     bool hit = GreedyDualBase::lookup(req);
     return hit;
 }
 
+bool LRUKCache::access(SimpleRequest* req)
+{
+    _curSlot = _history.reference(req->getId(), req->getSize(), ++_curTime);
+    return GreedyDualBase::access(req);
+}
+
 void LRUKCache::evict(SimpleRequest* req)
 {
     CacheObject obj(req);
-    _refsMap.erase(obj); // delete LRU-K info
     GreedyDualBase::evict(req);
+    _history.setEvicted(obj.id, obj.size); // retain LRU-K info
 }
 
 void LRUKCache::evict()
 {
-    // evict first list element (smallest value)
-    if (_valueMap.size() > 0) {
-        ValueMapIteratorType lit  = _valueMap.begin();
-        if (lit == _valueMap.end()) {
-            std::cerr << "underun: " << _currentSize << ' ' << _cacheSize << std::endl;
-        }
-        assert(lit != _valueMap.end()); // bug if this happens
-        CacheObject obj = lit->second;
-        _refsMap.erase(obj); // delete LRU-K info
+    // evict object with the smallest value
+    if (!_valueHeap.empty()) {
+        const uint32_t slot = _valueHeap.top();
+        CacheObject obj(_valueHeap.id(slot), _valueHeap.size(slot));
         GreedyDualBase::evict();
+        _history.setEvicted(obj.id, obj.size); // retain LRU-K info
     }
 }
 
 long double LRUKCache::ageValue(SimpleRequest* req)
 {
+    // called when the object is hit or inserted, i.e., it is resident
     CacheObject obj(req);
-    long double newVal = 0.0L;
-    if(_refsMap[obj].size() >= _tk) {
-        newVal = _refsMap[obj].front();
-        _refsMap[obj].pop();
+    uint32_t slot = _curSlot;
+    if (slot == FLAT_NPOS || _history.id(slot) != obj.id || _history.size(slot) != obj.size) {
+        slot = _history.find(obj.id, obj.size);
+        if (slot == FLAT_NPOS) {
+            // admitted without a lookup
+            return 0.0L;
+        }
     }
-    //std::cerr << id << " " << _curTime << " " << _refsMap[id].size() << " " << newVal << " " << _currentL << std::endl;
-    return newVal;
+    _history.setResident(slot);
+    return _history.kthTime(slot);
 }
 
 /*
   LFUDA
 */
-bool LFUDACache::lookup(SimpleRequest* req)
-{
-    bool hit = GreedyDualBase::lookup(req);
-    CacheObject obj(req);
-    if (!hit) {
-        _reqsMap[obj] = 1; //reset bec. reqs_map not updated when element removed
-    } else {
-        _reqsMap[obj]++;
-    }
-    return hit;
-}
-
-long double LFUDACache::ageValue(SimpleRequest* req)
+long double LFUDACache::countValue(uint64_t count, uint64_t size) const
 {
-    CacheObject obj(req);
-    return _currentL + _reqsMap[obj];
+    return _currentL + count;
 }
 
+/*
+  Statically dispatched replay engines
+*/
+template class StaticReplayEngine<GreedyDualBase>;
+template class StaticReplayEngine<GDSCache>;
+template class StaticReplayEngine<GDSFCache>;
+template class StaticReplayEngine<LRUKCache>;
+template class StaticReplayEngine<LFUDACache>;
@@ -2,33 +2,38 @@
 #define GD_VARIANTS_H
 
 #include <unordered_map>
-#include <map>
-#include <queue>
 #include "cache.h"
 #include "cache_object.h"
-
-typedef std::multimap<long double, CacheObject> ValueMapType;
-typedef ValueMapType::iterator ValueMapIteratorType;
-typedef std::unordered_map<CacheObject, ValueMapIteratorType> GdCacheMapType;
-typedef std::unordered_map<CacheObject, uint64_t> CacheStatsMapType;
+#include "indexed_heap.h"
+#include "lruk_history.h"
+#include "ghost_table.h"
 
 /*
   GD: greedy dual eviction (base class)
 
-  [implementation via heap: O(log n) time for each cache miss]
+  [implementation via heap: O(log n) time for each cache miss and hit]
 */
 class GreedyDualBase : public Cache
 {
 protected:
     // the GD current value
     long double _currentL = 0;
-    // ordered multi map of GD values, access object id + size
-    ValueMapType _valueMap;
-    // find objects via unordered_map
-    GdCacheMapType _cacheMap;
+    // heap of GD values, with an index to find objects
+    IndexedHeap _valueHeap;
 
     virtual long double ageValue(SimpleRequest* req);
-    virtual void hit(SimpleRequest* req);
+    virtual void hit(SimpleRequest* req, uint32_t slot);
+    // admission policy, asked on each miss before inserting the object
+    virtual bool admissible(SimpleRequest* req);
+    // lookup and admission given the object's hash h
+    bool lookupHashed(SimpleRequest* req, uint64_t h);
+    void admitHashed(SimpleRequest* req, uint64_t h);
+    // evict until obj fits, returns false if it can never fit
+    bool makeRoom(const CacheObject& obj);
+    // insert obj, for which there must be room, with GD value, returns its slot
+    uint32_t insert(const CacheObject& obj, uint64_t h, long double value);
+    // object evict() would remove next, false if empty
+    bool nextVictim(IdType& id, uint64_t& size) const;
 
 public:
     GreedyDualBase()
@@ -44,8 +49,11 @@ public:
     virtual void admit(SimpleRequest* req);
     virtual void evict(SimpleRequest* req);
     virtual void evict();
+    virtual bool access(SimpleRequest* req);
+    virtual void prefetch(const SimpleRequest* req);
 };
 
+extern template class StaticReplayEngine<GreedyDualBase>;
 static Factory<GreedyDualBase> factoryGD("GD");
 
 /*
@@ -66,43 +74,81 @@ public:
     }
 };
 
+extern template class StaticReplayEngine<GDSCache>;
 static Factory<GDSCache> factoryGDS("GDS");
 
 /*
-  Greedy Dual Size Frequency policy
+  GD with request counts (base class of GDSF and LFUDA)
+
+  The request count of a cached object lives in its heap table entry and
+  restarts at 1 when the object is admitted again. With ghost=n, the
+  counts of the last n evicted objects are remembered in a bounded ghost
+  table and continue when such an object returns.
 */
-class GDSFCache : public GreedyDualBase
+class GDFrequencyBase : public GreedyDualBase
 {
 protected:
-    CacheStatsMapType _reqsMap;
+    GhostTable _ghost;
 
     virtual long double ageValue(SimpleRequest* req);
+    // GD value of an object with count requests
+    virtual long double countValue(uint64_t count, uint64_t size) const = 0;
+    void countedHit(const CacheObject& obj, uint32_t slot);
+    void countedMiss(SimpleRequest* req, uint64_t h);
+    // remember the count of the object in slot, which is evicted
+    void retain(uint32_t slot);
 
 public:
-    GDSFCache()
+    GDFrequencyBase()
         : GreedyDualBase()
     {
     }
-    virtual ~GDSFCache()
+    virtual ~GDFrequencyBase()
     {
     }
 
+    virtual void setPar(std::string parName, std::string parValue);
     virtual bool lookup(SimpleRequest* req);
+    virtual void admit(SimpleRequest* req);
+    virtual bool access(SimpleRequest* req);
+    virtual void evict(SimpleRequest* req);
+    virtual void evict();
+};
+
+/*
+  Greedy Dual Size Frequency policy
+*/
+class GDSFCache : public GDFrequencyBase
+{
+protected:
+    virtual long double countValue(uint64_t count, uint64_t size) const;
+
+public:
+    GDSFCache()
+        : GDFrequencyBase()
+    {
+    }
+    virtual ~GDSFCache()
+    {
+    }
 };
 
+extern template class StaticReplayEngine<GDSFCache>;
 static Factory<GDSFCache> factoryGDSF("GDSF");
 
 /*
   LRU-K policy
 */
-typedef std::unordered_map<CacheObject, std::queue<uint64_t>> lrukMapType;
-
 class LRUKCache : public GreedyDualBase
 {
 protected:
-    lrukMapType _refsMap;
+    LRUKHistory _history;
     unsigned int _tk;
+    uint64_t _historyCapacity;
+    uint64_t _rip;
     uint64_t _curTime;
+    // history slot of the current request
+    uint32_t _curSlot;
 
     virtual long double ageValue(SimpleRequest* req);
 
@@ -114,34 +160,33 @@ public:
 
     virtual void setPar(std::string parName, std::string parValue);
     virtual bool lookup(SimpleRequest* req);
+    virtual bool access(SimpleRequest* req);
     virtual void evict(SimpleRequest* req);
     virtual void evict();
 };
 
+extern template class StaticReplayEngine<LRUKCache>;
 static Factory<LRUKCache> factoryLRUK("LRUK");
 
 /*
   LFUDA
 */
-class LFUDACache : public GreedyDualBase
+class LFUDACache : public GDFrequencyBase
 {
 protected:
-    CacheStatsMapType _reqsMap;
-
-    virtual long double ageValue(SimpleRequest* req);
+    virtual long double countValue(uint64_t count, uint64_t size) const;
 
 public:
     LFUDACache()
-        : GreedyDualBase()
+        : GDFrequencyBase()
     {
     }
     virtual ~LFUDACache()
     {
     }
-
-    virtual bool lookup(SimpleRequest* req);
 };
 
+extern template class StaticReplayEngine<LFUDACache>;
 static Factory<LFUDACache> factoryLFUDA("LFUDA");
 
 #endif /* GD_VARIANTS_H */
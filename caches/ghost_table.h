@@ -0,0 +1,115 @@
+#ifndef GHOST_TABLE_H
+#define GHOST_TABLE_H
+
+#include <vector>
+#include "flat_table.h"
+
+/*
+  GhostTable: bounded map from recently evicted objects to a value
+
+  Keeps the last capacity insertions in FIFO order: a ring of insertion
+  records decides which entry to drop when a new one arrives. Re-inserting
+  an object refreshes its value and its position (its older ring record
+  becomes stale and is skipped). A capacity of 0 disables the table.
+*/
+class GhostTable
+{
+protected:
+    struct Entry
+    {
+        IdType id;
+        uint64_t size;
+        uint64_t value;
+        uint64_t seq; // of the live ring record
+
+        Entry()
+            : id(0),
+              size(0),
+              value(0),
+              seq(0)
+        {
+        }
+    };
+
+    struct Record
+    {
+        IdType id;
+        uint64_t size;
+        uint64_t seq;
+    };
+
+    FlatTable<Entry> _table;
+    std::vector<Record> _ring;
+    size_t _next; // oldest ring record once the ring is full
+    uint64_t _seq;
+    uint64_t _capacity;
+
+    void erase(uint32_t slot) {
+        _table.erase(slot, [](uint32_t from, uint32_t to) {});
+    }
+
+public:
+    GhostTable()
+        : _next(0),
+          _seq(0),
+          _capacity(0)
+    {
+    }
+
+    // the table must still be empty
+    void setCapacity(uint64_t capacity) {
+        assert(_table.size() == 0);
+        _capacity = capacity;
+    }
+
+    void insert(IdType id, uint64_t size, uint64_t value) {
+        if (_capacity == 0) {
+            return;
+        }
+        if (_ring.size() == _capacity) {
+            // drop the oldest entry unless it was refreshed since
+            const Record& oldest = _ring[_next];
+            const uint32_t slot = _table.find(oldest.id, oldest.size);
+            if (slot != FLAT_NPOS && _table[slot].seq == oldest.seq) {
+                erase(slot);
+            }
+        }
+        const uint64_t h = FlatTable<Entry>::hash(id, size);
+        uint32_t slot = _table.find(id, size, h);
+        if (slot == FLAT_NPOS) {
+            slot = _table.insert(id, size, h, [](const std::vector<uint32_t>& oldToNew) {});
+        }
+        _table[slot].value = value;
+        _table[slot].seq = ++_seq;
+        Record r;
+        r.id = id;
+        r.size = size;
+        r.seq = _seq;
+        if (_ring.size() < _capacity) {
+            _ring.push_back(r);
+        } else {
+            _ring[_next] = r;
+            _next = (_next + 1) % _capacity;
+        }
+    }
+
+    // remove (id, size) and get its value, returns false if not present
+    bool take(IdType id, uint64_t size, uint64_t& value) {
+        if (_table.size() == 0) {
+            return false;
+        }
+        const uint32_t slot = _table.find(id, size);
+        if (slot == FLAT_NPOS) {
+            return false;
+        }
+        value = _table[slot].value;
+        erase(slot);
+        return true;
+    }
+
+    uint64_t count() const {
+        return _table.size();
+    }
+};
+
+#endif /* GHOST_TABLE_H */
@@ -0,0 +1,211 @@
+#ifndef INDEXED_HEAP_H
+#define INDEXED_HEAP_H
+
+#include <vector>
+#include "flat_table.h"
+
+/*
+  IndexedHeap: min-priority queue of CacheObjects with in-place updates
+
+  An array-based 4-ary heap of (value, sequence number, slot) nodes plus
+  a FlatTable that maps each object to its heap position, so a priority
+  change sifts the node in place instead of erasing and re-inserting a
+  tree node.
+
+  Tie-breaking: nodes with equal values are ordered by the sequence
+  number assigned at push/update, i.e., the object whose priority was set
+  earliest comes first. This is the order of the std::multimap used
+  before (emplace inserts after equal keys, begin() is the oldest).
+*/
+class IndexedHeap
+{
+protected:
+    static const size_t D = 4;
+
+    struct Entry
+    {
+        IdType id;
+        uint64_t size;
+        uint64_t frequency; // maintained by the policy, if it counts requests
+        uint32_t pos; // position in _heap
+
+        Entry()
+            : id(0),
+              size(0),
+              frequency(0),
+              pos(FLAT_NPOS)
+        {
+        }
+    };
+
+    struct Node
+    {
+        long double value;
+        uint64_t seq;
+        uint32_t slot; // slot in _table
+
+        bool operator<(const Node& rhs) const {
+            return value < rhs.value || (value == rhs.value && seq < rhs.seq);
+        }
+    };
+
+    FlatTable<Entry> _table;
+    std::vector<Node> _heap;
+    uint64_t _seq;
+
+    void place(size_t pos, const Node& n) {
+        _heap[pos] = n;
+        _table[n.slot].pos = pos;
+    }
+
+    // returns the levels the node moved
+    unsigned siftUp(size_t pos) {
+        const Node n = _heap[pos];
+        unsigned levels = 0;
+        while (pos > 0) {
+            const size_t parent = (pos - 1) / D;
+            if (!(n < _heap[parent])) {
+                break;
+            }
+            place(pos, _heap[parent]);
+            pos = parent;
+            levels++;
+        }
+        place(pos, n);
+        return levels;
+    }
+
+    unsigned siftDown(size_t pos) {
+        const Node n = _heap[pos];
+        const size_t count = _heap.size();
+        unsigned levels = 0;
+        while (true) {
+            const size_t first = D * pos + 1;
+            if (first >= count) {
+                break;
+            }
+            size_t best = first;
+            const size_t last = first + D < count ? first + D : count;
+            for (size_t c = first + 1; c < last; c++) {
+                if (_heap[c] < _heap[best]) {
+                    best = c;
+                }
+            }
+            if (!(_heap[best] < n)) {
+                break;
+            }
+            place(pos, _heap[best]);
+            pos = best;
+            levels++;
+        }
+        place(pos, n);
+        return levels;
+    }
+
+    // remove the node at pos from the heap
+    void removeAt(size_t pos) {
+        const Node last = _heap.back();
+        _heap.pop_back();
+        unsigned levels = 0;
+        if (pos < _heap.size()) {
+            place(pos, last);
+            levels = siftDown(pos);
+            levels += siftUp(_table[last.slot].pos);
+        }
+        INSTRUMENT_COUNT(HEAP_ERASES);
+        INSTRUMENT_RECORD(SIFT_STEPS, levels);
+    }
+
+public:
+    IndexedHeap()
+        : _seq(0)
+    {
+    }
+
+    static uint64_t hash(IdType id, uint64_t size) {
+        return FlatTable<Entry>::hash(id, size);
+    }
+
+    // slot of (id, size), FLAT_NPOS if not present
+    uint32_t find(IdType id, uint64_t size) const {
+        return _table.find(id, size);
+    }
+    uint32_t find(IdType id, uint64_t size, uint64_t h) const {
+        return _table.find(id, size, h);
+    }
+
+    void prefetch(IdType id, uint64_t size) const {
+        _table.prefetch(FlatTable<Entry>::hash(id, size));
+    }
+
+    // insert (id, size), which must not be present yet, with priority value
+    uint32_t push(IdType id, uint64_t size, long double value) {
+        return push(id, size, value, hash(id, size));
+    }
+    uint32_t push(IdType id, uint64_t size, long double value, uint64_t h) {
+        const uint32_t slot = _table.insert(id, size, h,
+                                            [this](const std::vector<uint32_t>& oldToNew) {
+                for (auto& n : _heap) {
+                    n.slot = oldToNew[n.slot];
+                }
+            });
+        Node n;
+        n.value = value;
+        n.seq = _seq++;
+        n.slot = slot;
+        _heap.push_back(n);
+        const unsigned levels = siftUp(_heap.size() - 1);
+        INSTRUMENT_COUNT(HEAP_PUSHES);
+        INSTRUMENT_RECORD(SIFT_STEPS, levels);
+        return slot;
+    }
+
+    // change the priority of the object in slot (it goes after equal values)
+    void update(uint32_t slot, long double value) {
+        const size_t pos = _table[slot].pos;
+        const bool up = value < _heap[pos].value;
+        _heap[pos].value = value;
+        _heap[pos].seq = _seq++;
+        const unsigned levels = up ? siftUp(pos) : siftDown(pos);
+        INSTRUMENT_COUNT(HEAP_UPDATES);
+        INSTRUMENT_RECORD(SIFT_STEPS, levels);
+    }
+
+    void erase(uint32_t slot) {
+        removeAt(_table[slot].pos);
+        _table.erase(slot, [this](uint32_t from, uint32_t to) {
+                _heap[_table[to].pos].slot = to;
+            });
+    }
+
+    // slot of the object with the smallest value, FLAT_NPOS if empty
+    uint32_t top() const {
+        return _heap.empty() ? FLAT_NPOS : _heap.front().slot;
+    }
+
+    // slot of the object at heap position pos < count(), e.g., to sample objects
+    uint32_t at(size_t pos) const {
+        return _heap[pos].slot;
+    }
+
+    long double value(uint32_t slot) const {
+        return _heap[_table[slot].pos].value;
+    }
+    IdType id(uint32_t slot) const {
+        return _table[slot].id;
+    }
+    uint64_t size(uint32_t slot) const {
+        return _table[slot].size;
+    }
+    uint64_t& frequency(uint32_t slot) {
+        return _table[slot].frequency;
+    }
+    uint64_t count() const {
+        return _heap.size();
+    }
+    bool empty() const {
+        return _heap.empty();
+    }
+};
+
+#endif /* INDEXED_HEAP_H */
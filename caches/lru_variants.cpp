@@ -11,72 +11,110 @@
 bool LRUCache::lookup(SimpleRequest* req)
 {
     CacheObject obj(req);
-    auto it = _cacheMap.find(obj);
-    if (it != _cacheMap.end()) {
-        // log hit
-        LOG("h", 0, obj.id, obj.size);
-        hit(it, obj.size);
+    return lookupHashed(obj, FlatLRUList::hash(obj.id, obj.size));
+}
+
+void LRUCache::admit(SimpleRequest* req)
+{
+    if (admissible(req)) {
+        CacheObject obj(req);
+        admitHashed(obj, FlatLRUList::hash(obj.id, obj.size));
+    }
+}
+
+bool LRUCache::access(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    const uint64_t h = FlatLRUList::hash(obj.id, obj.size);
+    if (lookupHashed(obj, h)) {
         return true;
     }
+    if (admissible(req)) {
+        admitHashed(obj, h);
+    }
     return false;
 }
 
-void LRUCache::admit(SimpleRequest* req)
+bool LRUCache::admissible(SimpleRequest* req)
+{
+    return true;
+}
+
+bool LRUCache::lookupHashed(const CacheObject& obj, uint64_t h)
+{
+    const uint32_t slot = _cacheList.find(obj.id, obj.size, h);
+    if (slot != FLAT_NPOS) {
+        hit(slot, obj.size);
+        return true;
+    }
+    return false;
+}
+
+void LRUCache::admitHashed(const CacheObject& obj, uint64_t h)
 {
-    const uint64_t size = req->getSize();
     // object feasible to store?
-    if (size > _cacheSize) {
-        LOG("L", _cacheSize, req->getId(), size);
+    if (obj.size > _cacheSize) {
+        INSTRUMENT_COUNT(BYPASSES);
         return;
     }
     // check eviction needed
-    while (_currentSize + size > _cacheSize) {
+    while (_currentSize + obj.size > _cacheSize) {
         evict();
     }
     // admit new object
-    CacheObject obj(req);
-    _cacheList.push_front(obj);
-    _cacheMap[obj] = _cacheList.begin();
-    _currentSize += size;
-    LOG("a", _currentSize, obj.id, obj.size);
+    _cacheList.pushFront(obj.id, obj.size, h);
+    _currentSize += obj.size;
+    admitted(obj.id, obj.size);
 }
 
 void LRUCache::evict(SimpleRequest* req)
 {
     CacheObject obj(req);
-    auto it = _cacheMap.find(obj);
-    if (it != _cacheMap.end()) {
-        ListIteratorType lit = it->second;
-        LOG("e", _currentSize, obj.id, obj.size);
+    const uint32_t slot = _cacheList.find(obj.id, obj.size);
+    if (slot != FLAT_NPOS) {
         _currentSize -= obj.size;
-        _cacheMap.erase(obj);
-        _cacheList.erase(lit);
+        _cacheList.erase(slot);
+        evicted(obj.id, obj.size);
     }
 }
 
 void LRUCache::evict()
 {
     // evict least popular (i.e. last element)
-    if (_cacheList.size() > 0) {
-        ListIteratorType lit = _cacheList.end();
-        lit--;
-        CacheObject obj = *lit;
-        LOG("e", _currentSize, obj.id, obj.size);
+    if (!_cacheList.empty()) {
+        const uint32_t slot = _cacheList.back();
+        CacheObject obj(_cacheList.id(slot), _cacheList.size(slot));
         _currentSize -= obj.size;
-        _cacheMap.erase(obj);
-        _cacheList.erase(lit);
+        _cacheList.erase(slot);
+        evicted(obj.id, obj.size);
+    }
+}
+
+bool LRUCache::nextVictim(IdType& id, uint64_t& size) const
+{
+    const uint32_t slot = _cacheList.back();
+    if (slot == FLAT_NPOS) {
+        return false;
     }
+    id = _cacheList.id(slot);
+    size = _cacheList.size(slot);
+    return true;
+}
+
+void LRUCache::hit(uint32_t slot, uint64_t size)
+{
+    _cacheList.moveToFront(slot);
 }
 
-void LRUCache::hit(lruCacheMapType::const_iterator it, uint64_t size)
+void LRUCache::prefetch(const SimpleRequest* req)
 {
-    _cacheList.splice(_cacheList.begin(), _cacheList, it->second);
+    _cacheList.prefetch(req->getId(), req->getSize());
 }
 
 /*
   FIFO: First-In First-Out eviction
 */
-void FIFOCache::hit(lruCacheMapType::const_iterator it, uint64_t size)
+void FIFOCache::hit(uint32_t slot, uint64_t size)
 {
 }
 
@@ -107,13 +145,24 @@ bool FilterCache::lookup(SimpleRequest* req)
     return LRUCache::lookup(req);
 }
 
-void FilterCache::admit(SimpleRequest* req)
+bool FilterCache::access(SimpleRequest* req)
 {
     CacheObject obj(req);
-    if (_filter[obj] <= _nParam) {
-        return;
+    const uint64_t count = ++_filter[obj];
+    const uint64_t h = FlatLRUList::hash(obj.id, obj.size);
+    if (lookupHashed(obj, h)) {
+        return true;
+    }
+    if (count > _nParam) {
+        admitHashed(obj, h);
     }
-    LRUCache::admit(req);
+    return false;
+}
+
+bool FilterCache::admissible(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    return _filter[obj] > _nParam;
 }
 
 
@@ -137,13 +186,10 @@ void ThLRUCache::setPar(std::string parName, std::string parValue) {
 }
 
 
-void ThLRUCache::admit(SimpleRequest* req)
+bool ThLRUCache::admissible(SimpleRequest* req)
 {
-    const uint64_t size = req->getSize();
     // admit if size < threshold
-    if (size < _sizeThreshold) {
-        LRUCache::admit(req);
-    }
+    return req->getSize() < _sizeThreshold;
 }
 
 
@@ -168,14 +214,161 @@ void ExpLRUCache::setPar(std::string parName, std::string parValue) {
 
 
 
-void ExpLRUCache::admit(SimpleRequest* req)
+bool ExpLRUCache::admissible(SimpleRequest* req)
 {
     const double size = req->getSize();
     // admit to cache with probablity that is exponentially decreasing with size
     double admissionProb = exp(-size/ _cParam);
     std::bernoulli_distribution distribution(admissionProb);
-    if (distribution(globalGenerator)) {
-        LRUCache::admit(req);
+    return distribution(globalGenerator);
+}
+
+/*
+  SLRU: segmented LRU with n segments
+*/
+SLRUCache::SLRUCache()
+    : LRUCache(),
+      _segmentPar(2, 0),
+      _segmentCapacity(2, 0),
+      _segmentSize(2, 0)
+{
+    _cacheList.setLists(2);
+}
+
+void SLRUCache::setSize(uint64_t cs)
+{
+    _cacheSize = cs;
+    resizeSegments();
+}
+
+void SLRUCache::setPar(std::string parName, std::string parValue) {
+    if(parName=="n") {
+        const int n = stoi(parValue);
+        assert(n>0 && n<=(int)FLAT_LRU_MAX_LISTS);
+        _cacheList.setLists(n);
+        _segmentPar.resize(n, 0);
+        _segmentCapacity.assign(n, 0);
+        _segmentSize.assign(n, 0);
+    } else if(parName.compare(0, 3, "seg")==0 && parName.size()>3) {
+        // segK, K counted from 1 (the segment new objects enter)
+        const size_t k = std::stoul(parName.substr(3));
+        const double capacity = std::stod(parValue);
+        assert(k>0 && k<=_segmentPar.size() && capacity>0);
+        _segmentPar[k-1] = capacity;
+    } else {
+        std::cerr << "unrecognized parameter: " << parName << std::endl;
+        return;
+    }
+    resizeSegments();
+}
+
+void SLRUCache::resizeSegments()
+{
+    // unset segments share what the set ones leave
+    uint64_t assigned = 0;
+    size_t unset = 0;
+    for (size_t i = 0; i < _segmentPar.size(); i++) {
+        if (_segmentPar[i] == 0) {
+            unset++;
+        } else {
+            _segmentCapacity[i] = _segmentPar[i] <= 1 ? _segmentPar[i] * _cacheSize : _segmentPar[i];
+            assigned += _segmentCapacity[i];
+        }
+    }
+    const uint64_t rest = assigned < _cacheSize ? _cacheSize - assigned : 0;
+    for (size_t i = 0; i < _segmentPar.size(); i++) {
+        if (_segmentPar[i] == 0) {
+            _segmentCapacity[i] = rest / unset;
+        } else if (assigned > _cacheSize) {
+            // set segments exceeding the cache size are scaled down to fit
+            _segmentCapacity[i] = static_cast<double>(_segmentCapacity[i]) * _cacheSize / assigned;
+        }
+    }
+    rebalance(_segmentPar.size() - 1);
+}
+
+void SLRUCache::rebalance(unsigned top)
+{
+    for (unsigned l = top; l > 0; l--) {
+        while (_segmentSize[l] > _segmentCapacity[l]) {
+            const uint32_t slot = _cacheList.back(l);
+            const uint64_t size = _cacheList.size(slot);
+            _cacheList.moveToFront(slot, l - 1);
+            _segmentSize[l] -= size;
+            _segmentSize[l - 1] += size;
+        }
+    }
+    while (_segmentSize[0] > _segmentCapacity[0]) {
+        remove(_cacheList.back(0));
+    }
+}
+
+void SLRUCache::hit(uint32_t slot, uint64_t size)
+{
+    const unsigned l = _cacheList.list(slot);
+    if (l + 1 < _cacheList.lists()) {
+        // promote
+        _cacheList.moveToFront(slot, l + 1);
+        _segmentSize[l] -= size;
+        _segmentSize[l + 1] += size;
+        rebalance(l + 1);
+    } else {
+        _cacheList.moveToFront(slot, l);
+    }
+}
+
+void SLRUCache::admitHashed(const CacheObject& obj, uint64_t h)
+{
+    // object feasible to store?
+    if (obj.size > _segmentCapacity[0]) {
+        INSTRUMENT_COUNT(BYPASSES);
+        return;
+    }
+    // make room in the first segment
+    while (_segmentSize[0] + obj.size > _segmentCapacity[0]) {
+        remove(_cacheList.back(0));
+    }
+    _cacheList.pushFront(obj.id, obj.size, h, 0);
+    _segmentSize[0] += obj.size;
+    _currentSize += obj.size;
+    admitted(obj.id, obj.size);
+}
+
+void SLRUCache::remove(uint32_t slot)
+{
+    CacheObject obj(_cacheList.id(slot), _cacheList.size(slot));
+    _segmentSize[_cacheList.list(slot)] -= obj.size;
+    _currentSize -= obj.size;
+    _cacheList.erase(slot);
+    evicted(obj.id, obj.size);
+}
+
+void SLRUCache::evict(SimpleRequest* req)
+{
+    CacheObject obj(req);
+    const uint32_t slot = _cacheList.find(obj.id, obj.size);
+    if (slot != FLAT_NPOS) {
+        remove(slot);
     }
 }
 
+void SLRUCache::evict()
+{
+    // least recent object of the lowest non-empty segment
+    for (unsigned l = 0; l < _cacheList.lists(); l++) {
+        if (_cacheList.back(l) != FLAT_NPOS) {
+            remove(_cacheList.back(l));
+            return;
+        }
+    }
+}
+
+/*
+  Statically dispatched replay engines
+*/
+template class StaticReplayEngine<LRUCache>;
+template class StaticReplayEngine<FIFOCache>;
+template class StaticReplayEngine<FilterCache>;
+template class StaticReplayEngine<ThLRUCache>;
+template class StaticReplayEngine<ExpLRUCache>;
+template class StaticReplayEngine<SLRUCache>;
@@ -2,12 +2,9 @@
 #define LRU_VARIANTS_H
 
 #include <unordered_map>
-#include <list>
 #include "cache.h"
 #include "cache_object.h"
-
-typedef std::list<CacheObject>::iterator ListIteratorType;
-typedef std::unordered_map<CacheObject, ListIteratorType> lruCacheMapType;
+#include "flat_lru.h"
 
 /*
   LRU: Least Recently Used eviction
@@ -15,12 +12,17 @@ typedef std::unordered_map<CacheObject, ListIteratorType> lruCacheMapType;
 class LRUCache : public Cache
 {
 protected:
-    // list for recency order
-    std::list<CacheObject> _cacheList;
-    // map to find objects in list
-    lruCacheMapType _cacheMap;
-
-    virtual void hit(lruCacheMapType::const_iterator it, uint64_t size);
+    // objects in recency order, with an embedded hash index
+    FlatLRUList _cacheList;
+
+    virtual void hit(uint32_t slot, uint64_t size);
+    // admission policy, asked on each miss before inserting the object
+    virtual bool admissible(SimpleRequest* req);
+    // lookup and admission given the object's hash h
+    bool lookupHashed(const CacheObject& obj, uint64_t h);
+    virtual void admitHashed(const CacheObject& obj, uint64_t h);
+    // object evict() would remove next, false if empty
+    bool nextVictim(IdType& id, uint64_t& size) const;
 
 public:
     LRUCache()
@@ -35,8 +37,11 @@ public:
     virtual void admit(SimpleRequest* req);
     virtual void evict(SimpleRequest* req);
     virtual void evict();
+    virtual bool access(SimpleRequest* req);
+    virtual void prefetch(const SimpleRequest* req);
 };
 
+extern template class StaticReplayEngine<LRUCache>;
 static Factory<LRUCache> factoryLRU("LRU");
 
 /*
@@ -45,7 +50,7 @@ static Factory<LRUCache> factoryLRU("LRU");
 class FIFOCache : public LRUCache
 {
 protected:
-    virtual void hit(lruCacheMapType::const_iterator it, uint64_t size);
+    virtual void hit(uint32_t slot, uint64_t size);
 
 public:
     FIFOCache()
@@ -57,6 +62,7 @@ public:
     }
 };
 
+extern template class StaticReplayEngine<FIFOCache>;
 static Factory<FIFOCache> factoryFIFO("FIFO");
 
 /*
@@ -68,6 +74,8 @@ protected:
     uint64_t _nParam;
     std::unordered_map<CacheObject, uint64_t> _filter;
 
+    virtual bool admissible(SimpleRequest* req);
+
 public:
     FilterCache();
     virtual ~FilterCache()
@@ -76,9 +84,10 @@ public:
 
     virtual void setPar(std::string parName, std::string parValue);
     virtual bool lookup(SimpleRequest* req);
-    virtual void admit(SimpleRequest* req);
+    virtual bool access(SimpleRequest* req);
 };
 
+extern template class StaticReplayEngine<FilterCache>;
 static Factory<FilterCache> factoryFilter("Filter");
 
 /*
@@ -89,6 +98,8 @@ class ThLRUCache : public LRUCache
 protected:
     uint64_t _sizeThreshold;
 
+    virtual bool admissible(SimpleRequest* req);
+
 public:
     ThLRUCache();
     virtual ~ThLRUCache()
@@ -96,9 +107,9 @@ public:
     }
 
     virtual void setPar(std::string parName, std::string parValue);
-    virtual void admit(SimpleRequest* req);
 };
 
+extern template class StaticReplayEngine<ThLRUCache>;
 static Factory<ThLRUCache> factoryThLRU("ThLRU");
 
 /*
@@ -109,6 +120,8 @@ class ExpLRUCache : public LRUCache
 protected:
     double _cParam;
 
+    virtual bool admissible(SimpleRequest* req);
+
 public:
     ExpLRUCache();
     virtual ~ExpLRUCache()
@@ -116,10 +129,52 @@ public:
     }
 
     virtual void setPar(std::string parName, std::string parValue);
-    virtual void admit(SimpleRequest* req);
 };
 
+extern template class StaticReplayEngine<ExpLRUCache>;
 static Factory<ExpLRUCache> factoryExpLRU("ExpLRU");
 
+/*
+  SLRU: segmented LRU with n segments (S2LRU: the default of two)
+
+  New objects enter the first segment, a hit moves an object to the front
+  of the next higher segment. A segment over its capacity demotes its
+  least recent objects to the front of the segment below, the first
+  segment evicts them. All segments share LRUCache's table, one recency
+  list each, so promotions and demotions relink an object in place.
+*/
+class SLRUCache : public LRUCache
+{
+protected:
+    // capacity of each segment as given: fraction of the cache size (<= 1), bytes (> 1), or 0 if unset
+    std::vector<double> _segmentPar;
+    // capacity and current size of each segment in bytes
+    std::vector<uint64_t> _segmentCapacity;
+    std::vector<uint64_t> _segmentSize;
+
+    virtual void hit(uint32_t slot, uint64_t size);
+    virtual void admitHashed(const CacheObject& obj, uint64_t h);
+    // derive the segment capacities from _segmentPar and the cache size
+    void resizeSegments();
+    // demote overflow from segment top downwards, evict overflow of the first segment
+    void rebalance(unsigned top);
+    void remove(uint32_t slot);
+
+public:
+    SLRUCache();
+    virtual ~SLRUCache()
+    {
+    }
+
+    virtual void setSize(uint64_t cs);
+    virtual void setPar(std::string parName, std::string parValue);
+    virtual void evict(SimpleRequest* req);
+    virtual void evict();
+};
+
+extern template class StaticReplayEngine<SLRUCache>;
+static Factory<SLRUCache> factorySLRU("SLRU");
+static Factory<SLRUCache> factoryS2LRU("S2LRU");
+
 
 #endif
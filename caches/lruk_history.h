@@ -0,0 +1,220 @@
+#ifndef LRUK_HISTORY_H
+#define LRUK_HISTORY_H
+
+#include "flat_table.h"
+
+// largest K supported by LRUKHistory
+static const unsigned LRUK_MAX_K = 8;
+
+/*
+  LRUKHistory: last K reference times per object in bounded memory
+
+  Each object's entry holds an inline ring of its last K reference times,
+  so recording a reference neither allocates nor grows anything.
+
+  Entries of resident objects are kept as long as the object is cached.
+  Entries of non-resident objects (evicted, or never admitted) form the
+  "retained information" of the LRU-K paper: they are kept in an
+  intrusive list ordered by their last reference (or eviction) and
+  dropped from its old end once more than capacity entries are retained
+  or, if rip > 0, once their last reference is more than rip requests in
+  the past (the Retained Information Period).
+
+  Entries are inserted and dropped only within reference(), so a slot
+  returned by reference() stays valid until the next call.
+*/
+class LRUKHistory
+{
+protected:
+    struct Entry
+    {
+        IdType id;
+        uint64_t size;
+        uint64_t times[LRUK_MAX_K];
+        uint32_t prev; // retained list, towards the front (most recent)
+        uint32_t next; // retained list, towards the back (oldest)
+        uint8_t head; // oldest time in the ring
+        uint8_t count;
+        bool resident;
+
+        Entry()
+            : id(0),
+              size(0),
+              prev(FLAT_NPOS),
+              next(FLAT_NPOS),
+              head(0),
+              count(0),
+              resident(false)
+        {
+        }
+    };
+
+    FlatTable<Entry> _table;
+    uint32_t _front;
+    uint32_t _back;
+    uint64_t _retained;
+    uint64_t _capacity;
+    uint64_t _rip;
+    unsigned _k;
+
+    void unlink(uint32_t slot) {
+        Entry& e = _table[slot];
+        if (e.prev != FLAT_NPOS) {
+            _table[e.prev].next = e.next;
+        } else {
+            _front = e.next;
+        }
+        if (e.next != FLAT_NPOS) {
+            _table[e.next].prev = e.prev;
+        } else {
+            _back = e.prev;
+        }
+        e.prev = e.next = FLAT_NPOS;
+        _retained--;
+    }
+
+    void linkFront(uint32_t slot) {
+        Entry& e = _table[slot];
+        e.prev = FLAT_NPOS;
+        e.next = _front;
+        if (_front != FLAT_NPOS) {
+            _table[_front].prev = slot;
+        } else {
+            _back = slot;
+        }
+        _front = slot;
+        _retained++;
+    }
+
+    uint64_t lastTime(uint32_t slot) const {
+        const Entry& e = _table[slot];
+        return e.times[(e.head + e.count - 1) % _k];
+    }
+
+    void erase(uint32_t slot) {
+        unlink(slot);
+        _table.erase(slot, [this](uint32_t from, uint32_t to) {
+                // entry moved from "from" to "to": redirect its neighbors
+                Entry& e = _table[to];
+                if (e.resident) {
+                    return;
+                }
+                if (e.prev != FLAT_NPOS) {
+                    _table[e.prev].next = to;
+                } else {
+                    _front = to;
+                }
+                if (e.next != FLAT_NPOS) {
+                    _table[e.next].prev = to;
+                } else {
+                    _back = to;
+                }
+            });
+    }
+
+    // drop retained entries beyond the capacity or the RIP
+    void trim(uint64_t now) {
+        while (_back != FLAT_NPOS
+               && (_retained > _capacity || (_rip > 0 && lastTime(_back) + _rip < now))) {
+            erase(_back);
+        }
+    }
+
+public:
+    LRUKHistory()
+        : _front(FLAT_NPOS),
+          _back(FLAT_NPOS),
+          _retained(0),
+          _capacity(0),
+          _rip(0),
+          _k(2)
+    {
+    }
+
+    // the history must still be empty
+    void configure(unsigned k, uint64_t capacity, uint64_t rip) {
+        assert(k > 0 && k <= LRUK_MAX_K);
+        assert(_table.size() == 0);
+        _k = k;
+        _capacity = capacity;
+        _rip = rip;
+    }
+
+    // record a reference to (id, size) at time now, returns its slot
+    uint32_t reference(IdType id, uint64_t size, uint64_t now) {
+        trim(now);
+        const uint64_t h = FlatTable<Entry>::hash(id, size);
+        uint32_t slot = _table.find(id, size, h);
+        if (slot == FLAT_NPOS) {
+            slot = _table.insert(id, size, h, [this](const std::vector<uint32_t>& oldToNew) {
+                    // free slots and resident entries have no links
+                    for (uint32_t i = 0; i < _table.capacity(); i++) {
+                        Entry& e = _table[i];
+                        e.prev = e.prev == FLAT_NPOS ? FLAT_NPOS : oldToNew[e.prev];
+                        e.next = e.next == FLAT_NPOS ? FLAT_NPOS : oldToNew[e.next];
+                    }
+                    _front = _front == FLAT_NPOS ? FLAT_NPOS : oldToNew[_front];
+                    _back = _back == FLAT_NPOS ? FLAT_NPOS : oldToNew[_back];
+                });
+            linkFront(slot);
+        } else if (!_table[slot].resident) {
+            unlink(slot);
+            linkFront(slot);
+        }
+        Entry& e = _table[slot];
+        if (e.count < _k) {
+            e.times[(e.head + e.count) % _k] = now;
+            e.count++;
+        } else {
+            // overwrite the oldest time
+            e.times[e.head] = now;
+            e.head = (e.head + 1) % _k;
+        }
+        return slot;
+    }
+
+    // slot of (id, size), FLAT_NPOS if there is no history
+    uint32_t find(IdType id, uint64_t size) const {
+        return _table.find(id, size);
+    }
+
+    IdType id(uint32_t slot) const {
+        return _table[slot].id;
+    }
+    uint64_t size(uint32_t slot) const {
+        return _table[slot].size;
+    }
+
+    // time of the K-th most recent reference, 0 if there are fewer than K
+    uint64_t kthTime(uint32_t slot) const {
+        const Entry& e = _table[slot];
+        return e.count < _k ? 0 : e.times[e.head];
+    }
+
+    // the object entered the cache, its entry is kept while it is resident
+    void setResident(uint32_t slot) {
+        if (!_table[slot].resident) {
+            unlink(slot);
+            _table[slot].resident = true;
+        }
+    }
+
+    // the object left the cache, its entry becomes retained information
+    void setEvicted(IdType id, uint64_t size) {
+        const uint32_t slot = _table.find(id, size);
+        if (slot != FLAT_NPOS && _table[slot].resident) {
+            _table[slot].resident = false;
+            linkFront(slot);
+        }
+    }
+
+    // number of entries, resident and retained
+    uint64_t count() const {
+        return _table.size();
+    }
+    uint64_t retained() const {
+        return _retained;
+    }
+};
+
+#endif /* LRUK_HISTORY_H */
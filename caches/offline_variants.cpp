@@ -0,0 +1,172 @@
+#include <cstdlib>
+#include <cassert>
+#include <unistd.h>
+#include "offline_variants.h"
+#include "random_helper.h"
+
+/*
+  OfflineCacheBase: policies that know each request's next reference
+*/
+void OfflineCacheBase::setPar(std::string parName, std::string parValue) {
+    if(parName=="next") {
+        _future.open(parValue.c_str());
+    } else if(parName=="trace") {
+        // annotate into a temporary file, which is gone once it is closed
+        const char* dir = getenv("TMPDIR");
+        std::string path = std::string(dir != nullptr ? dir : "/tmp") + "/webcachesim-next-XXXXXX";
+        const int fd = mkstemp(&path[0]);
+        if (fd < 0) {
+            std::cerr << "cannot create temporary next-reference file: " << path << std::endl;
+            return;
+        }
+        close(fd);
+        if (annotateNextReferences(parValue.c_str(), path.c_str()) >= 0) {
+            _future.open(path.c_str());
+        }
+        unlink(path.c_str());
+    } else {
+        std::cerr << "unrecognized parameter: " << parName << std::endl;
+    }
+}
+
+void OfflineCacheBase::advance()
+{
+    if (!_future.good() && !_missingFuture) {
+        std::cerr << "no next references, set next=file or trace=file" << std::endl;
+        _missingFuture = true;
+    }
+    _curNext = _future.next();
+    _now++;
+}
+
+long double OfflineCacheBase::ageValue(SimpleRequest* req)
+{
+    return -static_cast<long double>(_curNext);
+}
+
+bool OfflineCacheBase::lookup(SimpleRequest* req)
+{
+    advance();
+    return GreedyDualBase::lookup(req);
+}
+
+void OfflineCacheBase::admit(SimpleRequest* req)
+{
+    admitFuture(req, IndexedHeap::hash(req->getId(), req->getSize()));
+}
+
+bool OfflineCacheBase::access(SimpleRequest* req)
+{
+    advance();
+    const uint64_t h = IndexedHeap::hash(req->getId(), req->getSize());
+    if (lookupHashed(req, h)) {
+        return true;
+    }
+    admitFuture(req, h);
+    return false;
+}
+
+void OfflineCacheBase::admitFuture(SimpleRequest* req, uint64_t h)
+{
+    CacheObject obj(req);
+    if (_curNext == NEXT_NEVER || obj.size >= _cacheSize) {
+        return;
+    }
+    // take out victims until obj fits
+    _victims.clear();
+    uint64_t freed = 0;
+    while (_currentSize - freed + obj.size > _cacheSize) {
+        const uint32_t slot = victim(obj);
+        if (slot == FLAT_NPOS) {
+            break;
+        }
+        Victim v;
+        v.id = _valueHeap.id(slot);
+        v.size = _valueHeap.size(slot);
+        v.value = _valueHeap.value(slot);
+        _victims.push_back(v);
+        freed += v.size;
+        _valueHeap.erase(slot);
+    }
+    if (_currentSize - freed + obj.size > _cacheSize) {
+        // bypass: put the victims back
+        for (auto& v : _victims) {
+            INSTRUMENT_SCAN();
+            _valueHeap.push(v.id, v.size, v.value);
+        }
+        return;
+    }
+    for (auto& v : _victims) {
+        _currentSize -= v.size;
+        evicted(v.id, v.size);
+    }
+    insert(obj, h, ageValue(req));
+}
+
+/*
+  Belady: evict the object whose next reference is furthest in the future
+*/
+uint32_t BeladyCache::victim(const CacheObject& obj)
+{
+    const uint32_t slot = _valueHeap.top();
+    if (slot == FLAT_NPOS || -_valueHeap.value(slot) <= _curNext) {
+        return FLAT_NPOS;
+    }
+    return slot;
+}
+
+/*
+  BeladySize: size-aware approximation of OPT
+*/
+void BeladySizeCache::setPar(std::string parName, std::string parValue) {
+    if(parName=="samples") {
+        const uint64_t n = std::stoull(parValue);
+        assert(n>0);
+        _samples = n;
+    } else {
+        OfflineCacheBase::setPar(parName, parValue);
+    }
+}
+
+long double BeladySizeCache::cost(uint64_t next, uint64_t size) const
+{
+    // requests before the next reference, NEXT_NEVER is after all of them
+    return static_cast<long double>(next - _now) * size;
+}
+
+uint32_t BeladySizeCache::victim(const CacheObject& obj)
+{
+    const uint64_t count = _valueHeap.count();
+    if (count == 0) {
+        return FLAT_NPOS;
+    }
+    uint32_t best = FLAT_NPOS;
+    long double bestCost = cost(_curNext, obj.size);
+    if (count <= _samples) {
+        for (uint64_t pos = 0; pos < count; pos++) {
+            const uint32_t slot = _valueHeap.at(pos);
+            const long double c = cost(-_valueHeap.value(slot), _valueHeap.size(slot));
+            if (c > bestCost) {
+                best = slot;
+                bestCost = c;
+            }
+        }
+        return best;
+    }
+    std::uniform_int_distribution<uint64_t> position(0, count - 1);
+    for (uint64_t i = 0; i < _samples; i++) {
+        const uint32_t slot = _valueHeap.at(position(globalGenerator));
+        const long double c = cost(-_valueHeap.value(slot), _valueHeap.size(slot));
+        if (c > bestCost) {
+            best = slot;
+            bestCost = c;
+        }
+    }
+    return best;
+}
+
+/*
+  Statically dispatched replay engines
+*/
+template class StaticReplayEngine<BeladyCache>;
+template class StaticReplayEngine<BeladySizeCache>;
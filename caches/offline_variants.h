@@ -0,0 +1,127 @@
+#ifndef OFFLINE_VARIANTS_H
+#define OFFLINE_VARIANTS_H
+
+#include <vector>
+#include "cache.h"
+#include "cache_object.h"
+#include "gd_variants.h"
+#include "next_reference.h"
+
+/*
+  OfflineCacheBase: policies that know each request's next reference
+
+  Next references come from the pre-pass (see next_reference.h): either a
+  file written by the nextref tool (next=file) or computed from the trace
+  when the policy is configured (trace=file). They are consumed one per
+  lookup (or access), so the cache must replay exactly the annotated
+  trace from its start.
+
+  Cached objects sit in the GD heap with value -(next reference), so the
+  top is the object needed furthest in the future. A new object is
+  admitted only if room can be made by evicting victim()s that are worth
+  less than it; otherwise it bypasses the cache and nothing is evicted.
+  Objects never requested again are never admitted.
+*/
+class OfflineCacheBase : public GreedyDualBase
+{
+protected:
+    struct Victim
+    {
+        IdType id;
+        uint64_t size;
+        long double value;
+    };
+
+    NextReferenceReader _future;
+    // index of the current request and of its next reference
+    uint64_t _now;
+    uint64_t _curNext;
+    bool _missingFuture;
+    // victims taken out while trying to make room
+    std::vector<Victim> _victims;
+
+    // move on to the next request
+    void advance();
+    virtual long double ageValue(SimpleRequest* req);
+    // slot of the next object to evict to make room for obj (which is
+    // referenced next at _curNext), FLAT_NPOS if obj should bypass instead
+    virtual uint32_t victim(const CacheObject& obj) = 0;
+    void admitFuture(SimpleRequest* req, uint64_t h);
+
+public:
+    OfflineCacheBase()
+        : GreedyDualBase(),
+          _now(0),
+          _curNext(NEXT_NEVER),
+          _missingFuture(false)
+    {
+    }
+    virtual ~OfflineCacheBase()
+    {
+    }
+
+    virtual void setPar(std::string parName, std::string parValue);
+    virtual bool offline() const {
+        return true;
+    }
+    virtual bool lookup(SimpleRequest* req);
+    virtual void admit(SimpleRequest* req);
+    virtual bool access(SimpleRequest* req);
+};
+
+/*
+  Belady: evict the object whose next reference is furthest in the future
+
+  Optimal for the object hit ratio if all objects have the same size.
+*/
+class BeladyCache : public OfflineCacheBase
+{
+protected:
+    virtual uint32_t victim(const CacheObject& obj);
+
+public:
+    BeladyCache()
+        : OfflineCacheBase()
+    {
+    }
+    virtual ~BeladyCache()
+    {
+    }
+};
+
+extern template class StaticReplayEngine<BeladyCache>;
+static Factory<BeladyCache> factoryBelady("Belady");
+
+/*
+  BeladySize: size-aware approximation of OPT
+
+  Evicts the object with the largest (time to next reference) x size, i.e.,
+  the one that occupies the most byte-requests of cache space until it is
+  used again. These products change order as time passes, so the victim is
+  the largest of a random sample of cached objects instead of a heap top.
+*/
+class BeladySizeCache : public OfflineCacheBase
+{
+protected:
+    uint64_t _samples;
+
+    long double cost(uint64_t next, uint64_t size) const;
+    virtual uint32_t victim(const CacheObject& obj);
+
+public:
+    BeladySizeCache()
+        : OfflineCacheBase(),
+          _samples(64)
+    {
+    }
+    virtual ~BeladySizeCache()
+    {
+    }
+
+    virtual void setPar(std::string parName, std::string parValue);
+};
+
+extern template class StaticReplayEngine<BeladySizeCache>;
+static Factory<BeladySizeCache> factoryBeladySize("BeladySize");
+
+#endif /* OFFLINE_VARIANTS_H */
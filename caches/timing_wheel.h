@@ -0,0 +1,138 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <vector>
+#include <cstdint>
+#include "cache_object.h"
+
+/*
+  TimingWheel: hierarchical timing wheel of object expiration times
+
+  LEVELS wheels of SLOTS slots each. Level l has slots of SLOTS^l ticks, so
+  a timer due within SLOTS^(l+1) ticks goes to the level l slot of its due
+  time. Whenever the time crosses a multiple of SLOTS^l ticks, the timers
+  in the level l slot for the next SLOTS^l ticks are moved down a level
+  (cascaded). A timer is cascaded at most LEVELS - 1 times (more only if
+  it is due beyond SLOTS^LEVELS ticks), so scheduling and firing cost
+  amortized O(1). Stretches without timers on the lower levels are
+  skipped, so advancing over a long idle period does not visit every
+  tick.
+*/
+class TimingWheel
+{
+public:
+    struct Timer
+    {
+        IdType id;
+        uint64_t size;
+        uint64_t due;
+    };
+
+protected:
+    static const unsigned BITS = 8;
+    static const unsigned SLOTS = 1 << BITS;
+    static const unsigned LEVELS = 4;
+
+    std::vector<Timer> _slots[LEVELS][SLOTS];
+    uint64_t _levelCount[LEVELS];
+    uint64_t _count;
+    uint64_t _now;
+    // timers taken out of a slot while they are cascaded or fired
+    std::vector<Timer> _moving;
+
+    static unsigned slot(uint64_t t, unsigned level) {
+        return (t >> (BITS * level)) & (SLOTS - 1);
+    }
+
+    void place(const Timer& t) {
+        // t.due > _now
+        const uint64_t delta = t.due - _now;
+        unsigned level = 0;
+        while (level + 1 < LEVELS && delta >= uint64_t(1) << (BITS * (level + 1))) {
+            level++;
+        }
+        _slots[level][slot(t.due, level)].push_back(t);
+        _levelCount[level]++;
+        _count++;
+    }
+
+    // move the timers of the current level-l slot down, higher levels first
+    void cascade(unsigned level) {
+        const unsigned s = slot(_now, level);
+        if (s == 0 && level + 1 < LEVELS) {
+            cascade(level + 1);
+        }
+        _moving.clear();
+        _moving.swap(_slots[level][s]);
+        _levelCount[level] -= _moving.size();
+        _count -= _moving.size();
+        for (auto& t : _moving) {
+            place(t);
+        }
+    }
+
+public:
+    TimingWheel(uint64_t now = 0)
+        : _count(0),
+          _now(now)
+    {
+        for (unsigned l = 0; l < LEVELS; l++) {
+            _levelCount[l] = 0;
+        }
+    }
+
+    // schedule a timer, due must be in the future
+    void schedule(IdType id, uint64_t size, uint64_t due) {
+        Timer t;
+        t.id = id;
+        t.size = size;
+        t.due = due > _now ? due : _now + 1;
+        place(t);
+    }
+
+    // advance the time to now, fire(timer) is called for each timer due by then
+    template<class F> void advance(uint64_t now, F fire) {
+        while (_now < now) {
+            if (_count == 0) {
+                _now = now;
+                return;
+            }
+            // skip to the next slot boundary of the lowest level with timers
+            unsigned level = 0;
+            while (_levelCount[level] == 0) {
+                level++;
+            }
+            if (level > 0) {
+                const uint64_t boundary = ((_now >> (BITS * level)) + 1) << (BITS * level);
+                if (boundary > now) {
+                    _now = now;
+                    return;
+                }
+                _now = boundary - 1;
+            }
+            _now++;
+            if (slot(_now, 0) == 0) {
+                cascade(1);
+            }
+            std::vector<Timer>& due = _slots[0][slot(_now, 0)];
+            if (!due.empty()) {
+                _moving.clear();
+                _moving.swap(due);
+                _levelCount[0] -= _moving.size();
+                _count -= _moving.size();
+                for (auto& t : _moving) {
+                    fire(t);
+                }
+            }
+        }
+    }
+
+    uint64_t now() const {
+        return _now;
+    }
+    uint64_t count() const {
+        return _count;
+    }
+};
+
+#endif /* TIMING_WHEEL_H */
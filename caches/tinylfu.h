@@ -0,0 +1,176 @@
+#ifndef TINYLFU_H
+#define TINYLFU_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+/*
+  CountMinSketch: approximate request counts in constant memory
+
+  DEPTH rows of 4-bit saturating counters, packed 16 to a word. An
+  object's count is the minimum of its DEPTH counters (one per row, picked
+  by double hashing). Every counter is halved once sampleSize increments
+  have been recorded, so counts decay with age.
+*/
+class CountMinSketch
+{
+public:
+    // counters saturate at this count
+    static const uint64_t MAX_COUNT = 15;
+
+protected:
+    static const unsigned DEPTH = 4;
+
+    std::vector<uint64_t> _table; // DEPTH rows of width counters
+    uint64_t _mask; // width - 1
+    uint64_t _sampleSize;
+    uint64_t _samples;
+
+    uint64_t index(uint64_t h, unsigned row) const {
+        return row * (_mask + 1) + ((h + row * ((h >> 32) | 1)) & _mask);
+    }
+    uint64_t get(uint64_t i) const {
+        return (_table[i / 16] >> (4 * (i % 16))) & 0xf;
+    }
+
+public:
+    // width is rounded up to a power of two
+    CountMinSketch(uint64_t width = 1 << 16) {
+        resize(width);
+    }
+
+    // reset the sketch to width counters per row
+    void resize(uint64_t width) {
+        uint64_t w = 16;
+        while (w < width) {
+            w *= 2;
+        }
+        _table.assign(DEPTH * w / 16, 0);
+        _mask = w - 1;
+        _sampleSize = 10 * w;
+        _samples = 0;
+    }
+
+    uint64_t estimate(uint64_t h) const {
+        uint64_t count = MAX_COUNT;
+        for (unsigned row = 0; row < DEPTH; row++) {
+            const uint64_t c = get(index(h, row));
+            count = c < count ? c : count;
+        }
+        return count;
+    }
+
+    // count one request for h, returns true if this triggered a halving
+    bool increment(uint64_t h) {
+        for (unsigned row = 0; row < DEPTH; row++) {
+            const uint64_t i = index(h, row);
+            if (get(i) < MAX_COUNT) {
+                _table[i / 16] += uint64_t(1) << (4 * (i % 16));
+            }
+        }
+        if (++_samples >= _sampleSize) {
+            halve();
+            return true;
+        }
+        return false;
+    }
+
+    void halve() {
+        for (auto& word : _table) {
+            word = (word >> 1) & 0x7777777777777777ULL;
+        }
+        _samples /= 2;
+    }
+
+    uint64_t width() const {
+        return _mask + 1;
+    }
+    uint64_t bytes() const {
+        return _table.size() * sizeof(uint64_t);
+    }
+};
+
+/*
+  TinyLFU: frequency estimate for admission decisions (Einziger et al.)
+
+  The doorkeeper is a Bloom filter in front of the sketch: an object's
+  first request since the last halving only sets its doorkeeper bits, so
+  the many one-hit wonders do not occupy sketch counters. The doorkeeper
+  is cleared whenever the sketch is halved.
+*/
+class TinyLFU
+{
+protected:
+    static const unsigned DOORKEEPER_HASHES = 3;
+
+    CountMinSketch _sketch;
+    std::vector<uint64_t> _doorkeeper; // bit set, empty if disabled
+    uint64_t _doorkeeperMask;
+
+    uint64_t bit(uint64_t h, unsigned k) const {
+        return (h + k * (h >> 29 | 1)) & _doorkeeperMask;
+    }
+    bool inDoorkeeper(uint64_t h) const {
+        for (unsigned k = 0; k < DOORKEEPER_HASHES; k++) {
+            const uint64_t b = bit(h, k);
+            if (!(_doorkeeper[b / 64] >> (b % 64) & 1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    TinyLFU()
+        : _doorkeeperMask(0)
+    {
+        configure(1 << 16, true);
+    }
+
+    // width counters per sketch row, doorkeeper of 8 bits per sketch column
+    void configure(uint64_t width, bool doorkeeper) {
+        _sketch.resize(width);
+        _doorkeeper.clear();
+        if (doorkeeper) {
+            const uint64_t bits = 8 * _sketch.width();
+            _doorkeeper.assign(bits / 64, 0);
+            _doorkeeperMask = bits - 1;
+        }
+    }
+
+    uint64_t width() const {
+        return _sketch.width();
+    }
+    bool hasDoorkeeper() const {
+        return !_doorkeeper.empty();
+    }
+
+    // count one request of the object with hash h (see object_hash)
+    void record(uint64_t h) {
+        if (!_doorkeeper.empty() && !inDoorkeeper(h)) {
+            for (unsigned k = 0; k < DOORKEEPER_HASHES; k++) {
+                const uint64_t b = bit(h, k);
+                _doorkeeper[b / 64] |= uint64_t(1) << (b % 64);
+            }
+            return;
+        }
+        if (_sketch.increment(h)) {
+            std::fill(_doorkeeper.begin(), _doorkeeper.end(), 0);
+        }
+    }
+
+    uint64_t estimate(uint64_t h) const {
+        uint64_t count = _sketch.estimate(h);
+        if (!_doorkeeper.empty() && inDoorkeeper(h)) {
+            count++;
+        }
+        return count;
+    }
+
+    uint64_t bytes() const {
+        return _sketch.bytes() + _doorkeeper.size() * sizeof(uint64_t);
+    }
+};
+
+#endif /* TINYLFU_H */
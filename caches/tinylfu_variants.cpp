@@ -0,0 +1,7 @@
+#include "tinylfu_variants.h"
+
+/*
+  Statically dispatched replay engines
+*/
+template class StaticReplayEngine<TinyLFULRUCache>;
+template class StaticReplayEngine<TinyLFUGDSFCache>;
@@ -0,0 +1,82 @@
+#ifndef TINYLFU_VARIANTS_H
+#define TINYLFU_VARIANTS_H
+
+#include <string>
+#include <cassert>
+#include "cache.h"
+#include "cache_object.h"
+#include "tinylfu.h"
+#include "lru_variants.h"
+#include "gd_variants.h"
+
+/*
+  TinyLFU admission on top of an eviction policy
+
+  Every request is counted in a TinyLFU sketch (constant memory). On a
+  miss that requires an eviction, the new object is admitted only if its
+  estimated frequency is higher than that of the object the eviction
+  policy would evict next. Base is an LRUCache or GreedyDualBase variant;
+  its own admission rule (if any) still applies.
+*/
+template<class Base>
+class TinyLFUCache : public Base
+{
+protected:
+    TinyLFU _frequency;
+
+    virtual bool admissible(SimpleRequest* req) {
+        if (!Base::admissible(req)) {
+            return false;
+        }
+        // room left, no victim to compare with
+        if (this->_currentSize + req->getSize() <= this->_cacheSize) {
+            return true;
+        }
+        IdType victimId;
+        uint64_t victimSize;
+        if (!this->nextVictim(victimId, victimSize)) {
+            return true;
+        }
+        return _frequency.estimate(object_hash(req->getId(), req->getSize()))
+            > _frequency.estimate(object_hash(victimId, victimSize));
+    }
+
+public:
+    TinyLFUCache()
+        : Base()
+    {
+    }
+    virtual ~TinyLFUCache()
+    {
+    }
+
+    virtual void setPar(std::string parName, std::string parValue) {
+        if(parName=="w") {
+            const uint64_t w = std::stoull(parValue);
+            assert(w>0);
+            _frequency.configure(w, _frequency.hasDoorkeeper());
+        } else if(parName=="doorkeeper") {
+            _frequency.configure(_frequency.width(), std::stoi(parValue) != 0);
+        } else {
+            Base::setPar(parName, parValue);
+        }
+    }
+    virtual bool lookup(SimpleRequest* req) {
+        _frequency.record(object_hash(req->getId(), req->getSize()));
+        return Base::lookup(req);
+    }
+    virtual bool access(SimpleRequest* req) {
+        _frequency.record(object_hash(req->getId(), req->getSize()));
+        return Base::access(req);
+    }
+};
+
+typedef TinyLFUCache<LRUCache> TinyLFULRUCache;
+extern template class StaticReplayEngine<TinyLFULRUCache>;
+static Factory<TinyLFULRUCache> factoryTinyLFU("TinyLFU");
+
+typedef TinyLFUCache<GDSFCache> TinyLFUGDSFCache;
+extern template class StaticReplayEngine<TinyLFUGDSFCache>;
+static Factory<TinyLFUGDSFCache> factoryTinyLFUGDSF("TinyLFU-GDSF");
+
+#endif /* TINYLFU_VARIANTS_H */
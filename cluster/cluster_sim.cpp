@@ -0,0 +1,235 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include "cluster/cluster_sim.h"
+#include "random_helper.h"
+
+/*
+  ClusterNode: one cache of the cluster, replaying on its own thread
+*/
+ClusterNode::ClusterNode(std::unique_ptr<Cache> cache, uint64_t window)
+    : _cache(std::move(cache)),
+      _queue(1 << 14),
+      _window(window)
+{
+}
+
+void ClusterNode::start()
+{
+    _thread = std::thread(&ClusterNode::run, this);
+}
+
+void ClusterNode::submit(const ClusterRequest& req)
+{
+    while (!_queue.push(req)) {
+        std::this_thread::yield();
+    }
+}
+
+void ClusterNode::stop()
+{
+    ClusterRequest req = ClusterRequest();
+    req.seq = STOP;
+    submit(req);
+    _thread.join();
+}
+
+void ClusterNode::run()
+{
+    seedGenerator();
+    ClusterRequest batch[BATCH];
+    SimpleRequest reqs[BATCH];
+    uint64_t hits[BATCH / 64];
+    unsigned idle = 0;
+    while (true) {
+        const size_t n = _queue.pop(batch, BATCH);
+        if (n == 0) {
+            // back off from spinning when the front end is slower
+            if (++idle < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+            continue;
+        }
+        idle = 0;
+        // the stop request is the last one ever queued
+        const bool last = batch[n - 1].seq == STOP;
+        const size_t m = last ? n - 1 : n;
+        for (size_t i = 0; i < m; i++) {
+            reqs[i].reinit(batch[i].id, batch[i].size, batch[i].time, batch[i].ttl);
+        }
+        _cache->processBatch(reqs, m, hits);
+        for (size_t i = 0; i < m; i++) {
+            const bool hit = hits[i / 64] >> (i % 64) & 1;
+            _stats.reqs++;
+            _stats.bytes += batch[i].size;
+            _stats.hits += hit;
+            _stats.hitBytes += hit ? batch[i].size : 0;
+            if (_window > 0) {
+                const size_t w = batch[i].seq / _window;
+                if (w >= _stats.windowReqs.size()) {
+                    _stats.windowReqs.resize(w + 1, 0);
+                    _stats.windowHits.resize(w + 1, 0);
+                }
+                _stats.windowReqs[w]++;
+                _stats.windowHits[w] += hit;
+            }
+        }
+        if (last) {
+            return;
+        }
+    }
+}
+
+/*
+  ClusterSimulation: a cluster of caches behind a consistent-hash ring
+*/
+ClusterSimulation::ClusterSimulation(const std::string& cacheType, uint64_t cacheSize)
+    : _cacheType(cacheType),
+      _cacheSize(cacheSize),
+      _replicas(1),
+      _hot(0),
+      _window(0),
+      _nextEvent(0),
+      _seq(0)
+{
+}
+
+ClusterSimulation::~ClusterSimulation()
+{
+    finish();
+}
+
+bool ClusterSimulation::setPar(std::string parName, std::string parValue) {
+    if(parName=="vnodes") {
+        _ring.setVirtualNodes(std::stoul(parValue));
+    } else if(parName=="replicas") {
+        _replicas = std::max(1ul, std::stoul(parValue));
+    } else if(parName=="hot") {
+        _hot = std::stoull(parValue);
+    } else if(parName=="window") {
+        _window = std::stoull(parValue);
+    } else if(parName=="add") {
+        Event e;
+        e.seq = std::stoull(parValue);
+        e.add = true;
+        e.node = 0;
+        _events.push_back(e);
+    } else if(parName=="remove") {
+        // seq:node
+        const size_t colon = parValue.find(':');
+        if (colon == std::string::npos) {
+            std::cerr << "remove needs seq:node" << std::endl;
+            return true;
+        }
+        Event e;
+        e.seq = std::stoull(parValue.substr(0, colon));
+        e.add = false;
+        e.node = std::stoul(parValue.substr(colon + 1));
+        _events.push_back(e);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void ClusterSimulation::addCacheParam(const std::string& parName, const std::string& parValue)
+{
+    _cacheParams.push_back(std::make_pair(parName, parValue));
+}
+
+bool ClusterSimulation::start(unsigned nodes)
+{
+    // the sketch's counters saturate, so larger thresholds are never reached
+    if (_hot > CountMinSketch::MAX_COUNT) {
+        std::cerr << "hot must be at most " << CountMinSketch::MAX_COUNT << std::endl;
+        return false;
+    }
+    std::stable_sort(_events.begin(), _events.end());
+    for (unsigned i = 0; i < nodes; i++) {
+        if (!addNode()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ClusterSimulation::addNode()
+{
+    std::unique_ptr<Cache> cache = Cache::create_unique(_cacheType);
+    if (cache == nullptr) {
+        return false;
+    }
+    // each node only sees its part of the trace
+    if (cache->offline()) {
+        std::cerr << "offline policies cannot run on cluster nodes: " << _cacheType << std::endl;
+        return false;
+    }
+    cache->setSize(_cacheSize);
+    for (auto& p : _cacheParams) {
+        cache->configure(p.first, p.second);
+    }
+    const uint32_t node = _nodes.size();
+    _nodes.emplace_back(new ClusterNode(std::move(cache), _window));
+    _active.push_back(true);
+    _nodes.back()->start();
+    _ring.add(node);
+    return true;
+}
+
+void ClusterSimulation::removeNode(uint32_t node)
+{
+    if (node >= _nodes.size() || !_active[node] || _ring.nodes() == 1) {
+        std::cerr << "cannot remove node " << node << std::endl;
+        return;
+    }
+    _ring.remove(node);
+    _active[node] = false;
+    _nodes[node]->stop();
+}
+
+void ClusterSimulation::replay(const TraceRecord* begin, const TraceRecord* end)
+{
+    for (const TraceRecord* r = begin; r != end; ++r, ++_seq) {
+        while (_nextEvent < _events.size() && _events[_nextEvent].seq <= _seq) {
+            const Event& e = _events[_nextEvent++];
+            if (e.add) {
+                addNode();
+            } else {
+                removeNode(e.node);
+            }
+        }
+        if (_window > 0 && _seq % _window == 0) {
+            _windowNodes.push_back(_ring.nodes());
+        }
+        // shard by object id
+        const uint64_t h = hash_mix(r->id);
+        uint32_t node = _ring.lookup(h);
+        if (_replicas > 1 && _hot > 0) {
+            _sketch.increment(h);
+            if (_sketch.estimate(h) >= _hot) {
+                // hot: the replicas take turns
+                _ring.lookup(h, _replicas, _owners);
+                node = _owners[_seq % _owners.size()];
+            }
+        }
+        ClusterRequest req;
+        req.seq = _seq;
+        req.time = r->time;
+        req.id = r->id;
+        req.size = r->size;
+        req.ttl = r->ttl;
+        _nodes[node]->submit(req);
+    }
+}
+
+void ClusterSimulation::finish()
+{
+    for (uint32_t node = 0; node < _nodes.size(); node++) {
+        if (_active[node]) {
+            _active[node] = false;
+            _nodes[node]->stop();
+        }
+    }
+}
@@ -0,0 +1,158 @@
+#ifndef CLUSTER_SIM_H
+#define CLUSTER_SIM_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include "cache.h"
+#include "caches/tinylfu.h"
+#include "cluster/hash_ring.h"
+#include "cluster/spsc_queue.h"
+
+// a request routed to a node, seq is its position in the trace
+struct ClusterRequest {
+    uint64_t seq;
+    uint64_t time;
+    uint64_t id;
+    uint64_t size;
+    uint64_t ttl;
+};
+
+// statistics of a node, in total and per window of the trace
+struct NodeStats {
+    uint64_t reqs;
+    uint64_t hits;
+    uint64_t bytes;
+    uint64_t hitBytes;
+    std::vector<uint64_t> windowReqs;
+    std::vector<uint64_t> windowHits;
+
+    NodeStats()
+        : reqs(0),
+          hits(0),
+          bytes(0),
+          hitBytes(0)
+    {
+    }
+};
+
+/*
+  ClusterNode: one cache of the cluster, replaying on its own thread
+
+  The front end pushes the node's requests into its SPSC queue, the
+  node's thread pops them in batches and replays them on its cache. The
+  statistics belong to the node's thread until stop() joined it.
+*/
+class ClusterNode
+{
+protected:
+    static const size_t BATCH = 256;
+    // seq of the request that stops the thread
+    static const uint64_t STOP = UINT64_MAX;
+
+    std::unique_ptr<Cache> _cache;
+    SpscQueue<ClusterRequest> _queue;
+    std::thread _thread;
+    NodeStats _stats;
+    uint64_t _window;
+
+    void run();
+
+public:
+    ClusterNode(std::unique_ptr<Cache> cache, uint64_t window);
+
+    void start();
+    // enqueue a request, waits while the queue is full
+    void submit(const ClusterRequest& req);
+    // replay what is queued, then end the thread
+    void stop();
+
+    const NodeStats& stats() const {
+        return _stats;
+    }
+};
+
+/*
+  ClusterSimulation: a cluster of caches behind a consistent-hash ring
+
+  Requests are sharded by object id onto the nodes' caches (all of the
+  same type and size) through a HashRing with virtual nodes. With
+  replicas=r and hot=k, objects whose (sketched) request count reached k
+  are spread over the r nodes following their primary on the ring,
+  taking turns, so hot objects do not overload one node.
+
+  Nodes can be added or removed at given requests of the trace (add=seq,
+  remove=seq:node); a removed node's cache is lost and its keys move to
+  the next nodes on the ring, so the cluster's hit ratio dips until the
+  caches warm up again. Per-window statistics (window=n requests) show
+  the dip.
+*/
+class ClusterSimulation
+{
+protected:
+    struct Event
+    {
+        uint64_t seq;
+        bool add;
+        uint32_t node;
+
+        bool operator<(const Event& other) const {
+            return seq < other.seq;
+        }
+    };
+
+    std::string _cacheType;
+    uint64_t _cacheSize;
+    std::vector<std::pair<std::string, std::string> > _cacheParams;
+    std::vector<std::unique_ptr<ClusterNode> > _nodes;
+    std::vector<bool> _active;
+    HashRing _ring;
+    unsigned _replicas;
+    uint64_t _hot;
+    CountMinSketch _sketch;
+    uint64_t _window;
+    std::vector<Event> _events;
+    size_t _nextEvent;
+    uint64_t _seq;
+    std::vector<uint32_t> _owners;
+    // nodes active when each window began
+    std::vector<unsigned> _windowNodes;
+
+    bool addNode();
+    void removeNode(uint32_t node);
+
+public:
+    ClusterSimulation(const std::string& cacheType, uint64_t cacheSize);
+    ~ClusterSimulation();
+
+    // cluster parameters, returns false if parName is none of them
+    bool setPar(std::string parName, std::string parValue);
+    // applied to every node's cache, also to nodes added later
+    void addCacheParam(const std::string& parName, const std::string& parValue);
+    // start the cluster with n nodes
+    bool start(unsigned nodes);
+
+    void replay(const TraceRecord* begin, const TraceRecord* end);
+    // wait until all nodes replayed their requests and stopped
+    void finish();
+
+    unsigned nodes() const {
+        return _nodes.size();
+    }
+    bool active(uint32_t node) const {
+        return _active[node];
+    }
+    const NodeStats& stats(uint32_t node) const {
+        return _nodes[node]->stats();
+    }
+    uint64_t window() const {
+        return _window;
+    }
+    // nodes active when window w began
+    unsigned windowNodes(size_t w) const {
+        return _windowNodes[w];
+    }
+};
+
+#endif /* CLUSTER_SIM_H */
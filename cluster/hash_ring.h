@@ -0,0 +1,94 @@
+#ifndef HASH_RING_H
+#define HASH_RING_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "caches/cache_object.h"
+
+/*
+  HashRing: consistent hashing with virtual nodes
+
+  Each node owns vnodes points on a 64-bit ring, and a key belongs to the
+  node of the first point at or after the key's hash (wrapping around).
+  Adding or removing a node moves only the keys of its own points, about
+  1/n of all keys. The points are kept in one sorted array, so a lookup
+  is a binary search.
+*/
+class HashRing
+{
+protected:
+    struct Point
+    {
+        uint64_t hash;
+        uint32_t node;
+
+        bool operator<(const Point& other) const {
+            return hash < other.hash;
+        }
+    };
+
+    std::vector<Point> _points;
+    unsigned _vnodes;
+    unsigned _nodes;
+
+    static uint64_t pointHash(uint32_t node, unsigned v) {
+        return hash_mix((uint64_t(node) << 32) ^ (v * 0x9e3779b97f4a7c15ULL));
+    }
+    size_t successor(uint64_t h) const {
+        Point key;
+        key.hash = h;
+        const size_t i = std::lower_bound(_points.begin(), _points.end(), key) - _points.begin();
+        return i == _points.size() ? 0 : i;
+    }
+
+public:
+    HashRing(unsigned vnodes = 100)
+        : _vnodes(vnodes),
+          _nodes(0)
+    {
+    }
+
+    // points per node, call before adding nodes
+    void setVirtualNodes(unsigned vnodes) {
+        _vnodes = vnodes;
+    }
+
+    void add(uint32_t node) {
+        for (unsigned v = 0; v < _vnodes; v++) {
+            Point p;
+            p.hash = pointHash(node, v);
+            p.node = node;
+            _points.push_back(p);
+        }
+        std::sort(_points.begin(), _points.end());
+        _nodes++;
+    }
+    void remove(uint32_t node) {
+        _points.erase(std::remove_if(_points.begin(), _points.end(),
+                                     [node](const Point& p) { return p.node == node; }),
+                      _points.end());
+        _nodes--;
+    }
+
+    // node owning hash h, the ring must not be empty
+    uint32_t lookup(uint64_t h) const {
+        return _points[successor(h)].node;
+    }
+    // the first n distinct nodes clockwise from h (fewer if the ring has fewer)
+    void lookup(uint64_t h, unsigned n, std::vector<uint32_t>& nodes) const {
+        nodes.clear();
+        n = std::min(n, _nodes);
+        for (size_t i = successor(h); nodes.size() < n; i = (i + 1) % _points.size()) {
+            if (std::find(nodes.begin(), nodes.end(), _points[i].node) == nodes.end()) {
+                nodes.push_back(_points[i].node);
+            }
+        }
+    }
+
+    unsigned nodes() const {
+        return _nodes;
+    }
+};
+
+#endif /* HASH_RING_H */
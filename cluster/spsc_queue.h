@@ -0,0 +1,83 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+/*
+  SpscQueue: bounded lock-free queue of one producer and one consumer
+
+  A ring buffer of a power-of-two number of slots with monotonically
+  increasing head (next to pop, advanced by the consumer) and tail (next
+  to push, advanced by the producer) counters. Each side keeps a cached
+  copy of the other side's counter and reloads it only when the queue
+  looks full (or empty), so the shared cache lines are touched rarely.
+  The producer's and consumer's fields are padded onto separate cache
+  lines.
+*/
+template<class T>
+class SpscQueue
+{
+protected:
+    static const size_t LINE = 64;
+
+    std::vector<T> _slots;
+    uint64_t _mask;
+    char _pad0[LINE];
+    std::atomic<uint64_t> _head;
+    uint64_t _tailCache; // consumer's view of _tail
+    char _pad1[LINE];
+    std::atomic<uint64_t> _tail;
+    uint64_t _headCache; // producer's view of _head
+    char _pad2[LINE];
+
+public:
+    // capacity is rounded up to a power of two
+    SpscQueue(size_t capacity = 4096)
+        : _head(0),
+          _tailCache(0),
+          _tail(0),
+          _headCache(0)
+    {
+        size_t cap = 2;
+        while (cap < capacity) {
+            cap *= 2;
+        }
+        _slots.resize(cap);
+        _mask = cap - 1;
+    }
+
+    // producer: false if the queue is full
+    bool push(const T& value) {
+        const uint64_t t = _tail.load(std::memory_order_relaxed);
+        if (t - _headCache > _mask) {
+            _headCache = _head.load(std::memory_order_acquire);
+            if (t - _headCache > _mask) {
+                return false;
+            }
+        }
+        _slots[t & _mask] = value;
+        _tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer: pop up to n values into out, returns how many
+    size_t pop(T* out, size_t n) {
+        const uint64_t h = _head.load(std::memory_order_relaxed);
+        if (h == _tailCache) {
+            _tailCache = _tail.load(std::memory_order_acquire);
+        }
+        const uint64_t available = _tailCache - h;
+        n = n < available ? n : available;
+        for (size_t i = 0; i < n; i++) {
+            out[i] = _slots[(h + i) & _mask];
+        }
+        if (n > 0) {
+            _head.store(h + n, std::memory_order_release);
+        }
+        return n;
+    }
+};
+
+#endif /* SPSC_QUEUE_H */
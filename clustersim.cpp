@@ -0,0 +1,96 @@
+#include <string>
+#include <regex>
+#include <chrono>
+#include <iostream>
+#include "caches/lru_variants.h"
+#include "caches/gd_variants.h"
+#include "cluster/cluster_sim.h"
+#include "request.h"
+#include "trace_reader.h"
+
+using namespace std;
+
+int main (int argc, char* argv[])
+{
+
+  // output help if insufficient params
+  if(argc < 5) {
+    cerr << "clustersim traceFile cacheType cacheSizeBytes nodes [vnodes=n] [replicas=r] [hot=count] "
+         << "[window=requests] [add=seq]... [remove=seq:node]... [cacheParams]" << endl;
+    return 1;
+  }
+
+  // trace properties
+  const char* path = argv[1];
+
+  // every node gets a cache of this type and size
+  const string cacheType = argv[2];
+  const uint64_t cache_size  = std::stoull(argv[3]);
+  const unsigned nodes = std::stoul(argv[4]);
+  ClusterSimulation cluster(cacheType, cache_size);
+
+  // parse cluster and cache parameters
+  regex opexp ("(.*)=(.*)");
+  cmatch opmatch;
+  string paramSummary;
+  for(int i=5; i<argc; i++) {
+    regex_match (argv[i],opmatch,opexp);
+    if(opmatch.size()!=3) {
+      cerr << "each param needs to be in form name=value" << endl;
+      return 1;
+    }
+    if(!cluster.setPar(opmatch[1], opmatch[2]))
+      cluster.addCacheParam(opmatch[1], opmatch[2]);
+    paramSummary += opmatch[2];
+  }
+
+  // open text or binary trace
+  unique_ptr<TraceReader> trace = TraceReader::open(path);
+  if(trace == nullptr)
+    return 1;
+
+  if(!cluster.start(nodes))
+    return 1;
+
+  cerr << "running..." << endl;
+
+  const auto start = chrono::steady_clock::now();
+  const TraceRecord *begin, *end;
+  while (trace->nextChunk(begin, end))
+    cluster.replay(begin, end);
+  cluster.finish();
+  const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  // per node: requests, hits, hit ratio, share of the requests
+  uint64_t reqs = 0, hits = 0;
+  for(uint32_t n = 0; n < cluster.nodes(); n++) {
+    reqs += cluster.stats(n).reqs;
+    hits += cluster.stats(n).hits;
+  }
+  cout << cacheType << " " << cache_size << " " << nodes << " " << paramSummary << " "
+       << reqs << " " << hits << " " << double(hits)/reqs << " " << seconds << endl;
+  for(uint32_t n = 0; n < cluster.nodes(); n++) {
+    const NodeStats& ns = cluster.stats(n);
+    cout << "node" << n << " " << ns.reqs << " " << ns.hits << " "
+         << (ns.reqs > 0 ? double(ns.hits)/ns.reqs : 0) << " "
+         << double(ns.reqs)/reqs << endl;
+  }
+
+  // per window: first request, active nodes, requests, hits, hit ratio
+  if(cluster.window() > 0) {
+    for(size_t w = 0; w * cluster.window() < reqs; w++) {
+      uint64_t wreqs = 0, whits = 0;
+      for(uint32_t n = 0; n < cluster.nodes(); n++) {
+        const NodeStats& ns = cluster.stats(n);
+        if(w < ns.windowReqs.size()) {
+          wreqs += ns.windowReqs[w];
+          whits += ns.windowHits[w];
+        }
+      }
+      cout << "window " << w * cluster.window() << " " << cluster.windowNodes(w) << " "
+           << wreqs << " " << whits << " " << (wreqs > 0 ? double(whits)/wreqs : 0) << endl;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,40 @@
+#ifndef DEFERRED_EVICTIONS_H
+#define DEFERRED_EVICTIONS_H
+
+#include <vector>
+#include <utility>
+#include "cache.h"
+
+/*
+  DeferredEvictions: objects to evict from a policy once its current access returns
+
+  Storage layers underneath a policy (FlashCache, FlashDevice) learn of
+  objects they cannot keep while the policy is in the middle of an
+  admission, when it must not be re-entered. They collect them here and
+  apply them between the policy's accesses.
+*/
+class DeferredEvictions
+{
+protected:
+    std::vector<std::pair<IdType, uint64_t> > _objects;
+
+public:
+    void push(IdType id, uint64_t size) {
+        _objects.push_back(std::make_pair(id, size));
+    }
+    bool empty() const {
+        return _objects.empty();
+    }
+    // evict the collected objects from policy
+    void apply(Cache& policy) {
+        INSTRUMENT_SCOPE(policy);
+        while (!_objects.empty()) {
+            const std::pair<IdType, uint64_t> obj = _objects.back();
+            _objects.pop_back();
+            SimpleRequest req(obj.first, obj.second);
+            policy.evict(&req);
+        }
+    }
+};
+
+#endif /* DEFERRED_EVICTIONS_H */
@@ -0,0 +1,356 @@
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "flash/flash_cache.h"
+
+namespace {
+
+uint64_t alignUp(uint64_t x, uint64_t a)
+{
+    return (x + a - 1) / a * a;
+}
+
+char* allocAligned(uint64_t bytes, uint64_t align)
+{
+    void* p = nullptr;
+    if (posix_memalign(&p, align, bytes) != 0) {
+        return nullptr;
+    }
+    return static_cast<char*>(p);
+}
+
+}
+
+/*
+  FlashCache: key-value cache storing object payloads in a file or device
+*/
+FlashCache::FlashCache(std::unique_ptr<Cache> policy)
+    : _policy(std::move(policy)),
+      _fd(-1),
+      _deviceSize(0),
+      _segmentSize(16 << 20),
+      _overprovision(0.1),
+      _gc(RELOCATE),
+      _victimOrder(SegmentLog::GREEDY),
+      _bufferCount(4),
+      _direct(false),
+      _verify(true),
+      _openBuffer(nullptr),
+      _stop(false),
+      _readBuffer(nullptr)
+{
+}
+
+FlashCache::~FlashCache()
+{
+    if (_writer.joinable()) {
+        drain();
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            _stop = true;
+        }
+        _signal.notify_all();
+        _writer.join();
+    }
+    for (auto b : _buffers) {
+        free(b);
+    }
+    free(_readBuffer);
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+bool FlashCache::setPar(std::string parName, std::string parValue) {
+    if(parName=="segment") {
+        _segmentSize = alignUp(std::stoull(parValue), ALIGN);
+    } else if(parName=="op") {
+        _overprovision = std::stod(parValue);
+        assert(_overprovision >= 0 && _overprovision < 1);
+    } else if(parName=="gc") {
+        _gc = parValue == "evict" ? EVICT : RELOCATE;
+    } else if(parName=="victim") {
+        _victimOrder = parValue == "fifo" ? SegmentLog::FIFO : SegmentLog::GREEDY;
+    } else if(parName=="buffers") {
+        _bufferCount = std::max(2, std::stoi(parValue));
+    } else if(parName=="direct") {
+        _direct = std::stoi(parValue) != 0;
+    } else if(parName=="verify") {
+        _verify = std::stoi(parValue) != 0;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool FlashCache::open(const char* path, uint64_t deviceSize)
+{
+    assert(_fd < 0);
+    // a real cache serves requests online, without the trace's future
+    if (_policy->offline()) {
+        std::cerr << "offline policies cannot manage a flash cache" << std::endl;
+        return false;
+    }
+    int flags = O_RDWR | O_CREAT;
+#ifdef O_DIRECT
+    if (_direct) {
+        flags |= O_DIRECT;
+    }
+#endif
+    _fd = ::open(path, flags, 0644);
+    if (_fd < 0) {
+        std::cerr << "cannot open flash device: " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(_fd, &st) == 0 && S_ISREG(st.st_mode) && ftruncate(_fd, deviceSize) != 0) {
+        std::cerr << "cannot resize flash file: " << path << std::endl;
+        return false;
+    }
+    const uint64_t segments = deviceSize / _segmentSize;
+    if (segments < 3 || segments > UINT32_MAX) {
+        std::cerr << "flash device needs 3 or more segments of " << _segmentSize << " bytes" << std::endl;
+        return false;
+    }
+    _deviceSize = segments * _segmentSize;
+    _log.configure(segments, _segmentSize);
+    _inFlight.assign(segments, nullptr);
+
+    for (unsigned i = 0; i < _bufferCount; i++) {
+        char* b = allocAligned(_segmentSize, ALIGN);
+        if (b == nullptr) {
+            std::cerr << "cannot allocate segment buffers" << std::endl;
+            return false;
+        }
+        _buffers.push_back(b);
+        _idle.push_back(b);
+    }
+    _openBuffer = _idle.back();
+    _idle.pop_back();
+    _readBuffer = allocAligned(_segmentSize + 2 * ALIGN, ALIGN);
+    if (_readBuffer == nullptr) {
+        std::cerr << "cannot allocate read buffer" << std::endl;
+        return false;
+    }
+
+    _policy->setSize(_deviceSize * (1 - _overprovision));
+    _policy->addListener(this);
+    _writer = std::thread(&FlashCache::writerLoop, this);
+    return true;
+}
+
+bool FlashCache::get(SimpleRequest* req)
+{
+    _stats.reqs++;
+    _policy->tick(req);
+    const bool hit = _policy->access(req);
+    if (hit) {
+        _stats.hits++;
+        SegmentLog::Location loc;
+        const char* payload = nullptr;
+        if (_log.find(req->getId(), req->getSize(), loc)) {
+            payload = read(loc, req->getSize());
+        }
+        if (payload == nullptr || (_verify && !checkPayload(payload, req->getId(), req->getSize()))) {
+            _stats.verifyErrors++;
+        }
+    }
+    // the policy is not in the middle of an admission here
+    _deferred.apply(*_policy);
+    return hit;
+}
+
+void FlashCache::onAdmit(IdType id, uint64_t size)
+{
+    if (append(id, size, nullptr)) {
+        _stats.admittedBytes += size;
+    } else {
+        // cannot be stored, so it cannot stay cached
+        _deferred.push(id, size);
+        _stats.droppedBytes += size;
+    }
+}
+
+void FlashCache::onEvict(IdType id, uint64_t size)
+{
+    _log.remove(id, size);
+}
+
+bool FlashCache::append(IdType id, uint64_t size, const char* payload)
+{
+    if (size > _segmentSize) {
+        return false;
+    }
+    const bool room = _log.makeRoom(size, _victimOrder, [this]() { sealOpen(); },
+                                    [this](uint32_t s, bool relocate) {
+                                        cleanSegment(s, relocate && _gc == RELOCATE ? RELOCATE : EVICT);
+                                    });
+    if (!room) {
+        return false;
+    }
+    const SegmentLog::Location loc = _log.append(id, size);
+    if (payload != nullptr) {
+        memcpy(_openBuffer + loc.offset, payload, size);
+    } else {
+        fillPayload(_openBuffer + loc.offset, id, size);
+    }
+    return true;
+}
+
+void FlashCache::sealOpen()
+{
+    const uint32_t s = _log.openSegment();
+    if (s == FLAT_NPOS) {
+        return;
+    }
+    Flush f;
+    f.segment = s;
+    f.buffer = _openBuffer;
+    f.bytes = alignUp(_log.usedBytes(s), ALIGN);
+    _log.seal();
+    std::unique_lock<std::mutex> guard(_lock);
+    _inFlight[s] = _openBuffer;
+    _queue.push_back(f);
+    _signal.notify_all();
+    // wait for a buffer to fill next
+    _signal.wait(guard, [this]() { return !_idle.empty(); });
+    _openBuffer = _idle.back();
+    _idle.pop_back();
+}
+
+void FlashCache::cleanSegment(uint32_t s, GcMode mode)
+{
+    {
+        std::unique_lock<std::mutex> guard(_lock);
+        _signal.wait(guard, [this, s]() { return _inFlight[s] == nullptr; });
+    }
+    std::vector<SegmentLog::Record> live;
+    _log.clean(s, live);
+    _stats.cleanedSegments++;
+    if (mode == EVICT) {
+        for (auto& r : live) {
+            _deferred.push(r.id, r.size);
+            _stats.droppedBytes += r.size;
+        }
+        return;
+    }
+    // read all live payloads before anything is written to segment s again
+    std::vector<char> payloads;
+    for (auto& r : live) {
+        SegmentLog::Location loc;
+        loc.segment = s;
+        loc.offset = r.offset;
+        const char* p = read(loc, r.size);
+        if (p == nullptr) {
+            _deferred.push(r.id, r.size);
+            r.size = 0;
+            continue;
+        }
+        payloads.insert(payloads.end(), p, p + r.size);
+    }
+    uint64_t pos = 0;
+    for (auto& r : live) {
+        if (r.size == 0) {
+            continue;
+        }
+        if (append(r.id, r.size, payloads.data() + pos)) {
+            _stats.relocatedBytes += r.size;
+        } else {
+            _deferred.push(r.id, r.size);
+            _stats.droppedBytes += r.size;
+        }
+        pos += r.size;
+    }
+}
+
+const char* FlashCache::read(const SegmentLog::Location& loc, uint64_t size)
+{
+    if (loc.segment == _log.openSegment()) {
+        memcpy(_readBuffer, _openBuffer + loc.offset, size);
+        return _readBuffer;
+    }
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        if (_inFlight[loc.segment] != nullptr) {
+            memcpy(_readBuffer, _inFlight[loc.segment] + loc.offset, size);
+            return _readBuffer;
+        }
+    }
+    // aligned read covering the payload (required by O_DIRECT)
+    const uint64_t pos = loc.segment * _segmentSize + loc.offset;
+    const uint64_t begin = pos / ALIGN * ALIGN;
+    const uint64_t length = alignUp(pos + size, ALIGN) - begin;
+    uint64_t done = 0;
+    while (done < length) {
+        const ssize_t n = pread(_fd, _readBuffer + done, length - done, begin + done);
+        if (n <= 0) {
+            std::lock_guard<std::mutex> guard(_lock);
+            _stats.ioErrors++;
+            return nullptr;
+        }
+        done += n;
+    }
+    _stats.readBytes += length;
+    return _readBuffer + (pos - begin);
+}
+
+void FlashCache::drain()
+{
+    std::unique_lock<std::mutex> guard(_lock);
+    _signal.wait(guard, [this]() { return _queue.empty() && _idle.size() + 1 == _buffers.size(); });
+}
+
+void FlashCache::writerLoop()
+{
+    std::unique_lock<std::mutex> guard(_lock);
+    while (true) {
+        _signal.wait(guard, [this]() { return _stop || !_queue.empty(); });
+        if (_queue.empty()) {
+            return;
+        }
+        const Flush f = _queue.front();
+        _queue.pop_front();
+        guard.unlock();
+        // one large sequential write per segment
+        const uint64_t pos = f.segment * _segmentSize;
+        uint64_t done = 0;
+        bool failed = false;
+        while (done < f.bytes) {
+            const ssize_t n = pwrite(_fd, f.buffer + done, f.bytes - done, pos + done);
+            if (n <= 0) {
+                failed = true;
+                break;
+            }
+            done += n;
+        }
+        guard.lock();
+        _stats.writtenBytes += done;
+        _stats.ioErrors += failed;
+        _inFlight[f.segment] = nullptr;
+        _idle.push_back(f.buffer);
+        _signal.notify_all();
+    }
+}
+
+void FlashCache::fillPayload(char* dst, IdType id, uint64_t size)
+{
+    // id and size first, then a byte derived from the id
+    const uint64_t header[2] = {id, size};
+    const uint64_t h = std::min<uint64_t>(size, sizeof(header));
+    memcpy(dst, header, h);
+    memset(dst + h, static_cast<int>(id * 131 + 7) & 0xff, size - h);
+}
+
+bool FlashCache::checkPayload(const char* src, IdType id, uint64_t size)
+{
+    const uint64_t header[2] = {id, size};
+    const uint64_t h = std::min<uint64_t>(size, sizeof(header));
+    if (memcmp(src, header, h) != 0) {
+        return false;
+    }
+    return size == h || static_cast<unsigned char>(src[size - 1]) == (static_cast<unsigned>(id * 131 + 7) & 0xff);
+}
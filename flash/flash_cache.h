@@ -0,0 +1,149 @@
+#ifndef FLASH_CACHE_H
+#define FLASH_CACHE_H
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "cache.h"
+#include "flash/segment_log.h"
+#include "flash/deferred_evictions.h"
+
+// statistics of a FlashCache
+struct FlashStats {
+    uint64_t reqs;
+    uint64_t hits;
+    uint64_t admittedBytes; // object bytes the policy admitted and the log stored
+    uint64_t relocatedBytes; // live bytes rewritten by cleaning
+    uint64_t droppedBytes; // bytes the log could not keep or store
+    uint64_t writtenBytes; // bytes written to the device
+    uint64_t readBytes; // bytes read from the device
+    uint64_t cleanedSegments;
+    uint64_t verifyErrors; // hits whose payload did not match
+    uint64_t ioErrors;
+
+    FlashStats()
+        : reqs(0),
+          hits(0),
+          admittedBytes(0),
+          relocatedBytes(0),
+          droppedBytes(0),
+          writtenBytes(0),
+          readBytes(0),
+          cleanedSegments(0),
+          verifyErrors(0),
+          ioErrors(0)
+    {
+    }
+};
+
+/*
+  FlashCache: key-value cache storing object payloads in a file or device
+
+  Payloads live in a log-structured layout (see SegmentLog) on a local
+  file or block device; DRAM holds only the index and the segment being
+  filled. Which objects are cached is decided by any registered Cache
+  policy: the FlashCache listens to the policy's admissions (the payload
+  is appended to the log) and evictions (the payload becomes garbage).
+  The policy manages (1 - op) of the device capacity, the rest is
+  over-provisioning that keeps cleaning cheap.
+
+  When the log needs a free segment, a victim segment (victim=fifo or
+  greedy) is cleaned: its live objects are read back and rewritten at the
+  log head (gc=relocate), or evicted from the policy (gc=evict).
+
+  Sealed segments are written by a background thread with one large
+  pwrite each, while the replay keeps filling the next of several
+  segment buffers (buffers=n); it only waits when all buffers are in
+  flight. Hits read their payload with pread (or from a buffer not yet
+  written). Payloads carry their id and size, so hits can be verified.
+*/
+class FlashCache : public CacheListener
+{
+public:
+    enum GcMode {
+        RELOCATE,
+        EVICT
+    };
+
+protected:
+    static const uint64_t ALIGN = 4096;
+
+    std::unique_ptr<Cache> _policy;
+    SegmentLog _log;
+    int _fd;
+    uint64_t _deviceSize;
+    uint64_t _segmentSize;
+    double _overprovision;
+    GcMode _gc;
+    SegmentLog::VictimOrder _victimOrder;
+    unsigned _bufferCount;
+    bool _direct;
+    bool _verify;
+    FlashStats _stats;
+
+    // segment buffers: the open segment's, idle ones, and ones being written
+    std::vector<char*> _buffers;
+    char* _openBuffer;
+    std::vector<char*> _idle;
+    std::vector<char*> _inFlight; // per segment, nullptr if not in flight
+    struct Flush
+    {
+        uint32_t segment;
+        char* buffer;
+        uint64_t bytes;
+    };
+    std::deque<Flush> _queue;
+    std::thread _writer;
+    std::mutex _lock;
+    std::condition_variable _signal;
+    bool _stop;
+
+    // aligned scratch space for reads
+    char* _readBuffer;
+    DeferredEvictions _deferred;
+
+    static void fillPayload(char* dst, IdType id, uint64_t size);
+    static bool checkPayload(const char* src, IdType id, uint64_t size);
+
+    // the payload of size bytes at loc (in the read buffer), nullptr on error
+    const char* read(const SegmentLog::Location& loc, uint64_t size);
+    // append a payload (nullptr: a fresh one), false if it cannot be stored
+    bool append(IdType id, uint64_t size, const char* payload);
+    void sealOpen();
+    void cleanSegment(uint32_t s, GcMode mode);
+    void writerLoop();
+
+public:
+    FlashCache(std::unique_ptr<Cache> policy);
+    virtual ~FlashCache();
+
+    // flash parameters (path excluded), returns false if parName is none of them
+    bool setPar(std::string parName, std::string parValue);
+    // open (or create) the backing file or device, then size the policy
+    bool open(const char* path, uint64_t deviceSize);
+
+    Cache& policy() {
+        return *_policy;
+    }
+
+    // serve req: returns true on a hit (payload read from the log)
+    bool get(SimpleRequest* req);
+    // wait until all sealed segments are written
+    void drain();
+
+    // call drain() first, the writer thread updates writtenBytes
+    const FlashStats& stats() const {
+        return _stats;
+    }
+    const SegmentLog& log() const {
+        return _log;
+    }
+
+    virtual void onAdmit(IdType id, uint64_t size);
+    virtual void onEvict(IdType id, uint64_t size);
+};
+
+#endif /* FLASH_CACHE_H */
@@ -0,0 +1,216 @@
+#include <iostream>
+#include <cassert>
+#include "flash/flash_device.h"
+
+/*
+  FlashDevice: simulated flash device underneath a cache policy
+*/
+FlashDevice::FlashDevice()
+    : _policy(nullptr),
+      _placement(NONE),
+      _deviceSize(0),
+      _blockSize(4 << 20),
+      _pageSize(4096),
+      _overprovision(0.1),
+      _relocate(true),
+      _victimOrder(SegmentLog::GREEDY),
+      _valid(true)
+{
+}
+
+bool FlashDevice::setPar(std::string parName, std::string parValue) {
+    if(parName=="device") {
+        if(parValue=="log") {
+            _placement = LOG;
+        } else if(parValue=="set") {
+            _placement = SET;
+        } else {
+            std::cerr << "unrecognized device: " << parValue << std::endl;
+            _valid = false;
+        }
+    } else if(parName=="block") {
+        _blockSize = std::stoull(parValue);
+    } else if(parName=="page") {
+        _pageSize = std::stoull(parValue);
+    } else if(parName=="op") {
+        _overprovision = std::stod(parValue);
+        assert(_overprovision >= 0 && _overprovision < 1);
+    } else if(parName=="gc") {
+        _relocate = parValue != "evict";
+    } else if(parName=="victim") {
+        _victimOrder = parValue == "fifo" ? SegmentLog::FIFO : SegmentLog::GREEDY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool FlashDevice::attach(Cache& policy, uint64_t deviceSize)
+{
+    assert(_placement != NONE && _policy == nullptr);
+    const uint64_t blocks = deviceSize / _blockSize;
+    if (blocks < 3 || blocks > UINT32_MAX) {
+        std::cerr << "flash device needs 3 or more blocks of " << _blockSize << " bytes" << std::endl;
+        return false;
+    }
+    _deviceSize = blocks * _blockSize;
+    uint64_t capacity = _deviceSize * (1 - _overprovision);
+    _log.configure(blocks, _blockSize);
+    if (_placement == SET) {
+        // the FTL needs a spare block beyond the pages of all sets
+        const uint64_t pagesPerBlock = _blockSize / _pageSize;
+        const uint64_t sets = std::min(capacity / _pageSize, (blocks - 2) * pagesPerBlock);
+        if (pagesPerBlock == 0 || sets == 0) {
+            std::cerr << "flash device needs pages of at most " << _blockSize << " bytes" << std::endl;
+            return false;
+        }
+        _sets.assign(sets, Set());
+        capacity = sets * _pageSize;
+        std::cerr << "warning: device=set evicts the oldest objects of a full set, usually long before "
+                  << "the policy fills, so results hardly depend on the policy" << std::endl;
+    }
+    _policy = &policy;
+    _policy->setSize(capacity);
+    _policy->addListener(this);
+    return true;
+}
+
+void FlashDevice::replay(const TraceRecord* begin, const TraceRecord* end, ReplayStats& stats)
+{
+    SimpleRequest req;
+    for (const TraceRecord* r = begin; r != end; ++r) {
+        req.reinit(r->id, r->size, r->time, r->ttl);
+        _policy->tick(&req);
+        stats.reqs++;
+        stats.bytes += r->size;
+        if (_policy->access(&req)) {
+            stats.hits++;
+            stats.hitBytes += r->size;
+        }
+        applyDeferred();
+    }
+}
+
+void FlashDevice::drop(IdType id, uint64_t size)
+{
+    _deferred.push(id, size);
+    _stats.droppedBytes += size;
+}
+
+void FlashDevice::applyDeferred()
+{
+    _deferred.apply(*_policy);
+}
+
+void FlashDevice::onAdmit(IdType id, uint64_t size)
+{
+    const bool stored = _placement == LOG ? logAppend(id, size) : setAppend(id, size);
+    if (stored) {
+        _stats.admittedBytes += size;
+    } else {
+        drop(id, size);
+    }
+}
+
+void FlashDevice::onEvict(IdType id, uint64_t size)
+{
+    if (_placement == LOG) {
+        _log.remove(id, size);
+        return;
+    }
+    // the object's bytes are reclaimed when its page is rewritten next
+    Set& set = _sets[FlatTable<SetEntry>::hash(id, size) % _sets.size()];
+    for (auto it = set.objects.begin(); it != set.objects.end(); ++it) {
+        if (it->id == id && it->size == size) {
+            set.used -= size;
+            set.objects.erase(it);
+            break;
+        }
+    }
+}
+
+bool FlashDevice::logAppend(IdType id, uint64_t size)
+{
+    if (size > _blockSize) {
+        return false;
+    }
+    const bool room = _log.makeRoom(size, _victimOrder, [this]() { _log.seal(); },
+                                    [this](uint32_t block, bool relocate) {
+                                        logClean(block, relocate && _relocate);
+                                    });
+    if (!room) {
+        return false;
+    }
+    _log.append(id, size);
+    _stats.hostBytes += size;
+    _stats.nandBytes += size;
+    return true;
+}
+
+void FlashDevice::logClean(uint32_t block, bool relocate)
+{
+    std::vector<SegmentLog::Record> live;
+    _log.clean(block, live);
+    _stats.erasedBlocks++;
+    if (!relocate) {
+        for (auto& r : live) {
+            drop(r.id, r.size);
+        }
+        return;
+    }
+    for (auto& r : live) {
+        if (logAppend(r.id, r.size)) {
+            _stats.relocatedBytes += r.size;
+        } else {
+            drop(r.id, r.size);
+        }
+    }
+}
+
+bool FlashDevice::setAppend(IdType id, uint64_t size)
+{
+    if (size > _pageSize) {
+        return false;
+    }
+    const uint32_t s = FlatTable<SetEntry>::hash(id, size) % _sets.size();
+    Set& set = _sets[s];
+    size_t oldest = 0;
+    while (set.used + size > _pageSize) {
+        const SetEntry& victim = set.objects[oldest++];
+        set.used -= victim.size;
+        drop(victim.id, victim.size);
+    }
+    set.objects.erase(set.objects.begin(), set.objects.begin() + oldest);
+    SetEntry e;
+    e.id = id;
+    e.size = size;
+    set.objects.push_back(e);
+    set.used += size;
+    ftlWrite(s);
+    return true;
+}
+
+void FlashDevice::ftlWrite(uint32_t set)
+{
+    // the page's previous version becomes garbage
+    _log.remove(set, _pageSize);
+    while (!_log.fits(_pageSize)) {
+        _log.seal();
+        if (_log.open() != FLAT_NPOS) {
+            continue;
+        }
+        // some sealed block holds garbage as there are more pages than sets
+        std::vector<SegmentLog::Record> live;
+        _log.clean(_log.victim(SegmentLog::GREEDY), live);
+        _stats.erasedBlocks++;
+        _log.open();
+        for (auto& r : live) {
+            _log.append(r.id, r.size);
+            _stats.ftlRelocatedBytes += r.size;
+            _stats.nandBytes += r.size;
+        }
+    }
+    _log.append(set, _pageSize);
+    _stats.hostBytes += _pageSize;
+    _stats.nandBytes += _pageSize;
+}
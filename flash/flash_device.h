@@ -0,0 +1,134 @@
+#ifndef FLASH_DEVICE_H
+#define FLASH_DEVICE_H
+
+#include <vector>
+#include <string>
+#include "cache.h"
+#include "flash/segment_log.h"
+#include "flash/deferred_evictions.h"
+
+// write and garbage collection statistics of a FlashDevice
+struct DeviceStats {
+    uint64_t admittedBytes; // object bytes the policy admitted and the device stored
+    uint64_t hostBytes; // bytes the cache wrote to the device
+    uint64_t nandBytes; // bytes written to flash (host and FTL writes)
+    uint64_t relocatedBytes; // live object bytes rewritten by log cleaning
+    uint64_t ftlRelocatedBytes; // live page bytes rewritten by the FTL
+    uint64_t droppedBytes; // live object bytes the device could not keep
+    uint64_t erasedBlocks;
+
+    DeviceStats()
+        : admittedBytes(0),
+          hostBytes(0),
+          nandBytes(0),
+          relocatedBytes(0),
+          ftlRelocatedBytes(0),
+          droppedBytes(0),
+          erasedBlocks(0)
+    {
+    }
+};
+
+/*
+  FlashDevice: simulated flash device underneath a cache policy
+
+  The device listens to the policy's admissions and evictions and places
+  the admitted bytes on erase blocks, counting the bytes written to flash
+  and the garbage collection work. Objects the device cannot keep are
+  evicted from the policy after its current access, so the policy's hits
+  are hits on the device.
+
+  device=log: the device is a log of erase blocks (block=bytes) written
+  sequentially; evicted objects become garbage until their block is
+  cleaned (victim=greedy|fifo), which relocates its live objects to the
+  log head (gc=relocate) or evicts them (gc=evict). Whole blocks are
+  written, so the FTL adds no writes.
+
+  device=set: objects are hashed to sets of one page (page=bytes), and
+  admitting an object rewrites its whole page; a full set evicts its
+  oldest objects. The FTL maps the page writes to a log of erase blocks
+  and cleans the block with the fewest live pages, relocating them. As
+  hashing fills some sets long before the policy's capacity is used up,
+  the sets' FIFO evictions rather than the policy decide what is cached.
+
+  In both cases the policy manages (1 - op) of the device capacity, the
+  rest is over-provisioning.
+*/
+class FlashDevice : public CacheListener
+{
+public:
+    enum Placement {
+        NONE,
+        LOG,
+        SET
+    };
+
+protected:
+    struct SetEntry
+    {
+        IdType id;
+        uint64_t size;
+    };
+
+    struct Set
+    {
+        uint64_t used;
+        std::vector<SetEntry> objects; // oldest first
+    };
+
+    Cache* _policy;
+    Placement _placement;
+    uint64_t _deviceSize;
+    uint64_t _blockSize;
+    uint64_t _pageSize;
+    double _overprovision;
+    bool _relocate;
+    SegmentLog::VictimOrder _victimOrder;
+    DeviceStats _stats;
+
+    // device=log: objects; device=set: pages of the FTL, keyed by set
+    SegmentLog _log;
+    std::vector<Set> _sets;
+    DeferredEvictions _deferred;
+    // false after an unrecognized device parameter value
+    bool _valid;
+
+    void drop(IdType id, uint64_t size);
+    // device=log: append an object, false if it cannot be stored
+    bool logAppend(IdType id, uint64_t size);
+    void logClean(uint32_t block, bool relocate);
+    // device=set: store an object in its set, rewriting the set's page
+    bool setAppend(IdType id, uint64_t size);
+    void ftlWrite(uint32_t set);
+
+public:
+    FlashDevice();
+
+    // device parameters, returns false if parName is none of them
+    bool setPar(std::string parName, std::string parValue);
+    bool enabled() const {
+        return _placement != NONE;
+    }
+    bool valid() const {
+        return _valid;
+    }
+    // simulate a device of deviceSize bytes under policy, then size the policy
+    bool attach(Cache& policy, uint64_t deviceSize);
+
+    void replay(const TraceRecord* begin, const TraceRecord* end, ReplayStats& stats);
+    // evict the objects the device dropped from the policy, call only
+    // between the policy's accesses (replay does so after each request)
+    void applyDeferred();
+    bool hasDeferred() const {
+        return !_deferred.empty();
+    }
+
+    const DeviceStats& stats() const {
+        return _stats;
+    }
+
+    virtual void onAdmit(IdType id, uint64_t size);
+    virtual void onEvict(IdType id, uint64_t size);
+};
+
+#endif /* FLASH_DEVICE_H */
@@ -0,0 +1,263 @@
+#ifndef SEGMENT_LOG_H
+#define SEGMENT_LOG_H
+
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <cassert>
+#include "caches/flat_table.h"
+
+/*
+  SegmentLog: log-structured placement of objects in fixed-size segments
+
+  The device is divided into segments. Objects are appended to the one
+  open segment; once it cannot take the next object it is sealed and a
+  free segment is opened. Removing an object only drops it from the
+  index, its space becomes garbage until its segment is cleaned: the
+  segment's live objects are taken out (to be rewritten or dropped by the
+  caller) and the whole segment becomes free again.
+
+  The DRAM index maps each object to its segment and offset (24 bytes
+  per object). Each segment also lists the objects appended to it, so
+  cleaning visits only that segment's objects; the list is dropped when
+  the segment is cleaned.
+
+  makeRoom runs the seal/open/clean loop of the layers that store objects
+  in a log (FlashCache, FlashDevice), which decide how a segment is
+  sealed and what happens to the live objects of a cleaned one.
+*/
+class SegmentLog
+{
+public:
+    struct Location
+    {
+        uint32_t segment;
+        uint32_t offset; // within the segment
+    };
+
+    struct Record
+    {
+        IdType id;
+        uint64_t size;
+        uint32_t offset;
+    };
+
+    enum VictimOrder {
+        FIFO, // the segment sealed first
+        GREEDY // the segment with the fewest live bytes
+    };
+
+protected:
+    struct Entry
+    {
+        IdType id;
+        uint64_t size;
+        uint32_t segment;
+        uint32_t offset;
+    };
+
+    struct Segment
+    {
+        uint64_t used; // bytes appended
+        uint64_t live; // bytes of indexed objects
+        std::vector<Record> records;
+    };
+
+    FlatTable<Entry> _index;
+    std::vector<Segment> _segments;
+    std::vector<uint32_t> _free;
+    std::deque<uint32_t> _sealed; // in the order they were sealed
+    uint32_t _open;
+    uint64_t _segmentSize;
+    uint64_t _liveBytes;
+    bool _cleaning; // within makeRoom's clean callback
+
+public:
+    SegmentLog()
+        : _open(FLAT_NPOS),
+          _segmentSize(0),
+          _liveBytes(0),
+          _cleaning(false)
+    {
+    }
+
+    // segments of segmentSize bytes, the log must be empty
+    void configure(uint32_t segments, uint64_t segmentSize) {
+        assert(_index.size() == 0);
+        assert(segmentSize <= UINT32_MAX);
+        _segments.assign(segments, Segment());
+        _free.clear();
+        for (uint32_t s = segments; s-- > 0; ) {
+            _free.push_back(s);
+        }
+        _sealed.clear();
+        _open = FLAT_NPOS;
+        _segmentSize = segmentSize;
+    }
+
+    // the open segment has room for size bytes
+    bool fits(uint64_t size) const {
+        return _open != FLAT_NPOS && _segments[_open].used + size <= _segmentSize;
+    }
+    // seal the open segment, returns its number (FLAT_NPOS if none is open)
+    uint32_t seal() {
+        const uint32_t s = _open;
+        if (s != FLAT_NPOS) {
+            _sealed.push_back(s);
+            _open = FLAT_NPOS;
+        }
+        return s;
+    }
+    // open a free segment, returns its number, FLAT_NPOS if none is free
+    uint32_t open() {
+        assert(_open == FLAT_NPOS);
+        if (_free.empty()) {
+            return FLAT_NPOS;
+        }
+        _open = _free.back();
+        _free.pop_back();
+        return _open;
+    }
+
+    // append (id, size), which must fit and not be indexed, to the open segment
+    Location append(IdType id, uint64_t size) {
+        assert(fits(size));
+        Segment& seg = _segments[_open];
+        Location loc;
+        loc.segment = _open;
+        loc.offset = seg.used;
+        const uint64_t h = FlatTable<Entry>::hash(id, size);
+        const uint32_t slot = _index.insert(id, size, h, [](const std::vector<uint32_t>&) {});
+        _index[slot].segment = loc.segment;
+        _index[slot].offset = loc.offset;
+        Record r;
+        r.id = id;
+        r.size = size;
+        r.offset = loc.offset;
+        seg.records.push_back(r);
+        seg.used += size;
+        seg.live += size;
+        _liveBytes += size;
+        return loc;
+    }
+
+    bool find(IdType id, uint64_t size, Location& loc) const {
+        const uint32_t slot = _index.find(id, size);
+        if (slot == FLAT_NPOS) {
+            return false;
+        }
+        loc.segment = _index[slot].segment;
+        loc.offset = _index[slot].offset;
+        return true;
+    }
+
+    // drop (id, size) from the index, returns false if it was not indexed
+    bool remove(IdType id, uint64_t size) {
+        const uint32_t slot = _index.find(id, size);
+        if (slot == FLAT_NPOS) {
+            return false;
+        }
+        _segments[_index[slot].segment].live -= size;
+        _liveBytes -= size;
+        _index.erase(slot, [](uint32_t, uint32_t) {});
+        return true;
+    }
+
+    // make the open segment fit size bytes: sealOpen() (which must seal the
+    // open segment, if any) once it is full, then open a free segment or,
+    // if none is left, clean a victim (in order) via cleanVictim(s, relocate),
+    // which must clean(s) and rewrite or drop its live objects. relocate is
+    // false within cleanVictim and once as many segments as the log has were
+    // cleaned: relocating can only go in circles if (nearly) all data is live.
+    // Returns false if no sealed segment is left to clean.
+    template <typename Seal, typename Clean>
+    bool makeRoom(uint64_t size, VictimOrder order, const Seal& sealOpen, const Clean& cleanVictim) {
+        const bool nested = _cleaning;
+        uint32_t cleaned = 0;
+        while (!fits(size)) {
+            sealOpen();
+            if (open() != FLAT_NPOS) {
+                continue;
+            }
+            const uint32_t s = victim(order);
+            if (s == FLAT_NPOS) {
+                return false;
+            }
+            _cleaning = true;
+            cleanVictim(s, !nested && cleaned < segments());
+            _cleaning = nested;
+            cleaned++;
+        }
+        return true;
+    }
+
+    // sealed segment to clean next, FLAT_NPOS if none is sealed
+    uint32_t victim(VictimOrder order) const {
+        if (_sealed.empty()) {
+            return FLAT_NPOS;
+        }
+        if (order == FIFO) {
+            return _sealed.front();
+        }
+        uint32_t best = _sealed.front();
+        for (auto s : _sealed) {
+            if (_segments[s].live < _segments[best].live) {
+                best = s;
+            }
+        }
+        return best;
+    }
+
+    // free sealed segment s, its live objects are dropped from the index
+    // and returned in live (in append order) for the caller to rewrite or drop
+    void clean(uint32_t s, std::vector<Record>& live) {
+        live.clear();
+        Segment& seg = _segments[s];
+        for (auto& r : seg.records) {
+            const uint32_t slot = _index.find(r.id, r.size);
+            if (slot != FLAT_NPOS && _index[slot].segment == s && _index[slot].offset == r.offset) {
+                live.push_back(r);
+                _index.erase(slot, [](uint32_t, uint32_t) {});
+            }
+        }
+        _liveBytes -= seg.live;
+        seg.records.clear();
+        seg.records.shrink_to_fit();
+        seg.used = 0;
+        seg.live = 0;
+        for (auto it = _sealed.begin(); it != _sealed.end(); ++it) {
+            if (*it == s) {
+                _sealed.erase(it);
+                break;
+            }
+        }
+        _free.push_back(s);
+    }
+
+    uint64_t segmentSize() const {
+        return _segmentSize;
+    }
+    uint32_t segments() const {
+        return _segments.size();
+    }
+    uint32_t freeSegments() const {
+        return _free.size();
+    }
+    uint32_t openSegment() const {
+        return _open;
+    }
+    uint64_t usedBytes(uint32_t s) const {
+        return _segments[s].used;
+    }
+    uint64_t liveBytes(uint32_t s) const {
+        return _segments[s].live;
+    }
+    uint64_t liveBytes() const {
+        return _liveBytes;
+    }
+    uint64_t objects() const {
+        return _index.size();
+    }
+};
+
+#endif /* SEGMENT_LOG_H */
@@ -0,0 +1,98 @@
+#include <string>
+#include <regex>
+#include <chrono>
+#include <iostream>
+#include "caches/lru_variants.h"
+#include "caches/gd_variants.h"
+#include "flash/flash_cache.h"
+#include "analysis/latency_histogram.h"
+#include "request.h"
+#include "trace_reader.h"
+
+using namespace std;
+
+int main (int argc, char* argv[])
+{
+
+  // output help if insufficient params
+  if(argc < 5) {
+    cerr << "flashbench traceFile cacheType deviceSizeBytes path=deviceFile [segment=bytes] [op=fraction] "
+         << "[gc=relocate|evict] [victim=greedy|fifo] [buffers=n] [direct=0|1] [verify=0|1] [cacheParams]" << endl;
+    return 1;
+  }
+
+  // trace properties
+  const char* tracePath = argv[1];
+
+  // create policy
+  const string cacheType = argv[2];
+  unique_ptr<Cache> policy = Cache::create_unique(cacheType);
+  if(policy == nullptr)
+    return 1;
+  FlashCache flash(move(policy));
+
+  const uint64_t device_size = std::stoull(argv[3]);
+
+  // parse flash and cache parameters
+  regex opexp ("(.*)=(.*)");
+  cmatch opmatch;
+  string devicePath, paramSummary;
+  for(int i=4; i<argc; i++) {
+    regex_match (argv[i],opmatch,opexp);
+    if(opmatch.size()!=3) {
+      cerr << "each param needs to be in form name=value" << endl;
+      return 1;
+    }
+    if(opmatch[1]=="path") {
+      devicePath = opmatch[2];
+      continue;
+    }
+    if(!flash.setPar(opmatch[1], opmatch[2]))
+      flash.policy().configure(opmatch[1], opmatch[2]);
+    paramSummary += opmatch[2];
+  }
+  if(devicePath.empty()) {
+    cerr << "path=deviceFile is required" << endl;
+    return 1;
+  }
+  if(!flash.open(devicePath.c_str(), device_size))
+    return 1;
+
+  // open text or binary trace
+  unique_ptr<TraceReader> trace = TraceReader::open(tracePath);
+  if(trace == nullptr)
+    return 1;
+
+  cerr << "running..." << endl;
+
+  LatencyHistogram latency;
+  SimpleRequest req(0, 0);
+  const auto start = chrono::steady_clock::now();
+  const TraceRecord *begin, *end;
+  while (trace->nextChunk(begin, end)) {
+    for (const TraceRecord* r = begin; r != end; ++r) {
+      req.reinit(r->id, r->size, r->time, r->ttl);
+      const auto t0 = chrono::steady_clock::now();
+      flash.get(&req);
+      latency.record(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count());
+    }
+  }
+  flash.drain();
+  const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  // write amplification: device bytes written per byte admitted by the policy
+  const FlashStats& stats = flash.stats();
+  cout << cacheType << " " << device_size << " " << paramSummary << " "
+       << stats.reqs << " " << stats.hits << " "
+       << double(stats.hits)/stats.reqs << " "
+       << seconds << " " << stats.reqs/seconds << " "
+       << stats.admittedBytes << " " << stats.writtenBytes << " "
+       << (stats.admittedBytes > 0 ? double(stats.writtenBytes)/stats.admittedBytes : 0) << " "
+       << stats.relocatedBytes << " " << stats.droppedBytes << " "
+       << stats.cleanedSegments << " "
+       << latency.percentile(0.5) << " " << latency.percentile(0.99) << " "
+       << latency.percentile(0.999) << " "
+       << stats.verifyErrors << " " << stats.ioErrors << endl;
+
+  return 0;
+}
@@ -0,0 +1,140 @@
+#include "instrumentation.h"
+
+#ifdef CINSTRUMENT
+
+#include <iostream>
+#include <mutex>
+
+/*
+  Instrumentation: per-policy counters and histograms of hot-path work
+*/
+static const char* const counterNames[] = {
+    "accesses", "admissions", "evictions", "expirations", "bypasses", "scans",
+    "heap_pushes", "heap_updates", "heap_erases"
+};
+static const char* const histogramNames[] = {
+    "probes_per_lookup", "evict_steps_per_admission", "sift_steps_per_heap_op", "evicted_bytes"
+};
+
+// policy names and merged counters, written to stderr at exit
+class InstrumentationTotals
+{
+public:
+    std::mutex lock;
+    std::vector<std::string> names;
+    std::vector<Instrumentation::Counters> policies;
+
+    InstrumentationTotals()
+        : names(1, "unnamed")
+    {
+    }
+    ~InstrumentationTotals() {
+        for (size_t p = 0; p < policies.size(); p++) {
+            const Instrumentation::Counters& c = policies[p];
+            if (c.counters[Instrumentation::ACCESSES] == 0 && c.histograms[Instrumentation::PROBES].count == 0) {
+                continue;
+            }
+            std::cerr << "instrumentation " << names[p] << "\n";
+            for (unsigned i = 0; i < Instrumentation::COUNTERS; i++) {
+                std::cerr << "  " << counterNames[i] << " " << c.counters[i] << "\n";
+            }
+            // count, mean and max, then the non-empty buckets as "upper bound:count"
+            for (unsigned i = 0; i < Instrumentation::HISTOGRAMS; i++) {
+                const Instrumentation::Log2Histogram& h = c.histograms[i];
+                std::cerr << "  " << histogramNames[i] << " " << h.count << " "
+                          << (h.count > 0 ? double(h.sum) / h.count : 0) << " " << h.max;
+                for (unsigned b = 0; b < 65; b++) {
+                    if (h.buckets[b] > 0) {
+                        std::cerr << " <" << (b == 0 ? 1 : b == 64 ? UINT64_MAX : uint64_t(1) << b) << ":" << h.buckets[b];
+                    }
+                }
+                std::cerr << "\n";
+            }
+        }
+    }
+};
+
+static InstrumentationTotals& totals()
+{
+    static InstrumentationTotals t;
+    return t;
+}
+
+thread_local Instrumentation::Buffer Instrumentation::_buffer;
+
+Instrumentation::Log2Histogram::Log2Histogram()
+    : count(0),
+      sum(0),
+      max(0)
+{
+    for (auto& b : buckets) {
+        b = 0;
+    }
+}
+
+void Instrumentation::Log2Histogram::merge(const Log2Histogram& other)
+{
+    for (unsigned b = 0; b < 65; b++) {
+        buckets[b] += other.buckets[b];
+    }
+    count += other.count;
+    sum += other.sum;
+    max = other.max > max ? other.max : max;
+}
+
+Instrumentation::Counters::Counters()
+    : steps(0)
+{
+    for (auto& c : counters) {
+        c = 0;
+    }
+}
+
+void Instrumentation::Counters::merge(const Counters& other)
+{
+    for (unsigned i = 0; i < COUNTERS; i++) {
+        counters[i] += other.counters[i];
+    }
+    for (unsigned i = 0; i < HISTOGRAMS; i++) {
+        histograms[i].merge(other.histograms[i]);
+    }
+}
+
+Instrumentation::Buffer::Buffer()
+    : current(0)
+{
+    // the totals must outlive every buffer
+    totals();
+}
+
+Instrumentation::Buffer::~Buffer()
+{
+    Instrumentation::merge(*this);
+}
+
+unsigned Instrumentation::policy(const std::string& name)
+{
+    InstrumentationTotals& t = totals();
+    std::lock_guard<std::mutex> guard(t.lock);
+    for (unsigned p = 0; p < t.names.size(); p++) {
+        if (t.names[p] == name) {
+            return p;
+        }
+    }
+    t.names.push_back(name);
+    return t.names.size() - 1;
+}
+
+void Instrumentation::merge(const Buffer& buffer)
+{
+    InstrumentationTotals& t = totals();
+    std::lock_guard<std::mutex> guard(t.lock);
+    if (t.policies.size() < buffer.policies.size()) {
+        t.policies.resize(buffer.policies.size());
+    }
+    for (size_t p = 0; p < buffer.policies.size(); p++) {
+        t.policies[p].merge(buffer.policies[p]);
+    }
+}
+
+#endif /* CINSTRUMENT */
@@ -0,0 +1,172 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+// uncomment (or build with "make instrument") to count hot-path events:
+// #define CINSTRUMENT 1
+
+#ifdef CINSTRUMENT
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+  Instrumentation: per-policy counters and histograms of hot-path work
+
+  Policies and the data structures they use report events through the
+  INSTRUMENT_* macros below, which compile to nothing unless CINSTRUMENT
+  is defined. Each thread counts into its own buffer, with no locks or
+  atomics; a buffer is merged into the global totals when its thread
+  exits, and the totals are written to stderr at program exit.
+
+  Events are charged to the policy a thread currently serves: Cache::tick
+  selects it before each access, and callers that interleave several
+  policies (e.g., the tiers of a hierarchy) select the policy they call
+  with an INSTRUMENT_SCOPE. Policies created through a Factory are named
+  after their registered cache type.
+*/
+class Instrumentation
+{
+public:
+    enum Counter {
+        ACCESSES, // ticks, i.e., requests served
+        ADMISSIONS,
+        EVICTIONS,
+        EXPIRATIONS,
+        BYPASSES, // objects too large to be admitted
+        SCANS, // objects an eviction looked at but kept
+        HEAP_PUSHES,
+        HEAP_UPDATES,
+        HEAP_ERASES,
+        COUNTERS
+    };
+    enum Histogram {
+        PROBES, // slots probed per hash table lookup
+        EVICT_STEPS, // objects evicted or scanned per admission
+        SIFT_STEPS, // levels a heap node moved per heap operation
+        EVICTED_SIZE, // bytes per evicted object
+        HISTOGRAMS
+    };
+
+    // log2 histogram: bucket b counts values in [2^(b-1), 2^b), bucket 0 zeros
+    struct Log2Histogram
+    {
+        uint64_t buckets[65];
+        uint64_t count;
+        uint64_t sum;
+        uint64_t max;
+
+        Log2Histogram();
+        void record(uint64_t v) {
+            buckets[v == 0 ? 0 : 64 - __builtin_clzll(v)]++;
+            count++;
+            sum += v;
+            max = v > max ? v : max;
+        }
+        void merge(const Log2Histogram& other);
+    };
+
+    struct Counters
+    {
+        uint64_t counters[COUNTERS];
+        Log2Histogram histograms[HISTOGRAMS];
+        uint64_t steps; // eviction steps since the policy's last admission (not merged)
+
+        Counters();
+        void merge(const Counters& other);
+    };
+
+    // a thread's counters, one set per policy
+    struct Buffer
+    {
+        std::vector<Counters> policies;
+        unsigned current; // policy served now
+
+        Buffer();
+        ~Buffer();
+        Counters& counters() {
+            if (current >= policies.size()) {
+                policies.resize(current + 1);
+            }
+            return policies[current];
+        }
+    };
+
+    static thread_local Buffer _buffer;
+
+    // number of the policy named name (0: unnamed policies)
+    static unsigned policy(const std::string& name);
+    // add a buffer to the totals
+    static void merge(const Buffer& buffer);
+
+    static Counters& local() {
+        return _buffer.counters();
+    }
+    static void enter(unsigned policy) {
+        _buffer.current = policy;
+        local().counters[ACCESSES]++;
+    }
+    static void admitted() {
+        Counters& c = local();
+        c.counters[ADMISSIONS]++;
+        c.histograms[EVICT_STEPS].record(c.steps);
+        c.steps = 0;
+    }
+    static void evicted(uint64_t size, bool expiring) {
+        Counters& c = local();
+        if (expiring) {
+            c.counters[EXPIRATIONS]++;
+        } else {
+            c.counters[EVICTIONS]++;
+            c.histograms[EVICTED_SIZE].record(size);
+            c.steps++;
+        }
+    }
+    static void scanned() {
+        Counters& c = local();
+        c.counters[SCANS]++;
+        c.steps++;
+    }
+
+    // charges events to a policy until it goes out of scope
+    class Scope
+    {
+        unsigned _previous;
+
+    public:
+        Scope(unsigned policy)
+            : _previous(_buffer.current)
+        {
+            _buffer.current = policy;
+        }
+        ~Scope() {
+            _buffer.current = _previous;
+        }
+    };
+};
+
+#define INSTRUMENT_POLICY(id, name) (id) = Instrumentation::policy(name)
+#define INSTRUMENT_ENTER(id) Instrumentation::enter(id)
+// charge the events of the rest of the block to cache's policy
+#define INSTRUMENT_SCOPE(cache) Instrumentation::Scope instrumentScope((cache).instrumentId())
+#define INSTRUMENT_ADMIT() Instrumentation::admitted()
+#define INSTRUMENT_EVICT(size, expiring) Instrumentation::evicted(size, expiring)
+#define INSTRUMENT_SCAN() Instrumentation::scanned()
+#define INSTRUMENT_COUNT(c) Instrumentation::local().counters[Instrumentation::c]++
+#define INSTRUMENT_RECORD(h, v) Instrumentation::local().histograms[Instrumentation::h].record(v)
+
+#else
+
+#define INSTRUMENT_POLICY(id, name)
+#define INSTRUMENT_ENTER(id)
+#define INSTRUMENT_SCOPE(cache)
+#define INSTRUMENT_ADMIT()
+#define INSTRUMENT_EVICT(size, expiring)
+#define INSTRUMENT_SCAN()
+#define INSTRUMENT_COUNT(c)
+// v is still evaluated (and then optimized away), so it must have no side effects
+#define INSTRUMENT_RECORD(h, v) (void)(v)
+
+#endif /* CINSTRUMENT */
+
+#endif /* INSTRUMENTATION_H */
@@ -0,0 +1,137 @@
+#include <string>
+#include <regex>
+#include <sstream>
+#include <cmath>
+#include "caches/lru_variants.h"
+#include "caches/gd_variants.h"
+#include "analysis/policy_curve.h"
+#include "analysis/shards.h"
+#include "analysis/stack_distance.h"
+#include "request.h"
+#include "trace_reader.h"
+
+using namespace std;
+
+int main (int argc, char* argv[])
+{
+
+  // output help if insufficient params
+  if(argc < 2) {
+    cerr << "mrc traceFile [sizes=s1,s2,...] [min=log2Min] [max=log2Max] [steps=pointsPerDoubling]"
+         << " [rate=samplingRate|samples=maxObjects] [groups=n] [adjust=0|1] [policy=cacheType [cacheParams]]" << endl;
+    return 1;
+  }
+
+  // trace properties
+  const char* path = argv[1];
+
+  // cache sizes: either an explicit list or a log2-spaced grid
+  vector<uint64_t> sizes;
+  double minLog2 = 10, maxLog2 = 40;
+  uint64_t steps = 1;
+  // spatial sampling
+  double rate = 1.0;
+  uint64_t samples = 0;
+  int groups = -1;
+  bool adjust = false;
+  // policy (default: LRU via stack distances)
+  string cacheType;
+  vector<pair<string, string> > cacheParams;
+
+  // parse params
+  regex opexp ("(.*)=(.*)");
+  cmatch opmatch;
+  for(int i=2; i<argc; i++) {
+    regex_match (argv[i],opmatch,opexp);
+    if(opmatch.size()!=3) {
+      cerr << "each param needs to be in form name=value" << endl;
+      return 1;
+    }
+    const string parName = opmatch[1], parValue = opmatch[2];
+    if(parName=="sizes") {
+      stringstream ss(parValue);
+      string size;
+      while(getline(ss, size, ','))
+        sizes.push_back(stoull(size));
+    } else if(parName=="min") {
+      minLog2 = stod(parValue);
+    } else if(parName=="max") {
+      maxLog2 = stod(parValue);
+    } else if(parName=="steps") {
+      steps = stoull(parValue);
+    } else if(parName=="rate") {
+      rate = stod(parValue);
+    } else if(parName=="samples") {
+      samples = stoull(parValue);
+    } else if(parName=="groups") {
+      groups = stoi(parValue);
+    } else if(parName=="adjust") {
+      adjust = stoi(parValue) != 0;
+    } else if(parName=="policy") {
+      cacheType = parValue;
+    } else if(!cacheType.empty()) {
+      // everything after policy= configures the policy
+      cacheParams.push_back(make_pair(parName, parValue));
+    } else {
+      cerr << "unrecognized parameter: " << parName << endl;
+      return 1;
+    }
+  }
+  if(sizes.empty()) {
+    if(steps == 0 || maxLog2 < minLog2) {
+      cerr << "empty cache size grid" << endl;
+      return 1;
+    }
+    for(uint64_t i=0; minLog2 + double(i)/steps <= maxLog2; i++)
+      sizes.push_back(llround(pow(2.0, minLog2 + double(i)/steps)));
+  }
+
+  if(rate <= 0 || rate > 1) {
+    cerr << "sampling rate must be in (0,1]" << endl;
+    return 1;
+  }
+  // estimate the sampling error only if sampling
+  const bool sampling = rate < 1 || samples > 0;
+  if(groups < 0)
+    groups = sampling ? 8 : 0;
+
+  // hit ratio curve of LRU (stack distances) or any other policy (one cache per size)
+  function<unique_ptr<HitRatioCurve>()> makeCurve = [&]() {
+    if(cacheType.empty())
+      return unique_ptr<HitRatioCurve>(new LRUStackDistance(sizes));
+    return unique_ptr<HitRatioCurve>(new PolicyCurve(sizes, cacheType, cacheParams));
+  };
+  if(!cacheType.empty() && !PolicyCurve(vector<uint64_t>(1, 1), cacheType, cacheParams).good())
+    return 1;
+
+  // open text or binary trace
+  unique_ptr<TraceReader> trace = TraceReader::open(path);
+  if(trace == nullptr)
+    return 1;
+
+  cerr << "running..." << endl;
+
+  ShardsEstimator est(rate, samples, groups, makeCurve, adjust);
+  const TraceRecord *begin, *end;
+  while (trace->nextChunk(begin, end))
+    {
+      for(const TraceRecord* rec = begin; rec != end; ++rec)
+        est.access(rec->id, rec->size, rec->time, rec->ttl);
+    }
+
+  if(sampling)
+    cerr << "sampled " << est.sampledReqs() << " of " << est.reqs()
+         << " requests, final rate " << est.rate() << endl;
+
+  // one row per cache size: size, object hit ratio, byte hit ratio [, standard errors]
+  for(size_t i=0; i<est.capacities().size(); i++) {
+    cout << est.capacities()[i] << " "
+         << est.objectHitRatio(i) << " "
+         << est.byteHitRatio(i);
+    if(est.hasError())
+      cout << " " << est.objectHitRatioError(i) << " " << est.byteHitRatioError(i);
+    cout << endl;
+  }
+
+  return 0;
+}
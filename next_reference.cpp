@@ -0,0 +1,169 @@
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include "next_reference.h"
+#include "trace_reader.h"
+#include "caches/flat_table.h"
+
+// entries read per refill of a NextReferenceReader
+static const size_t NEXT_READ_ENTRIES = 1 << 16;
+
+namespace {
+
+struct LastReference
+{
+    IdType id;
+    uint64_t size;
+    uint64_t index;
+};
+
+bool writeAll(int fd, const void* data, size_t bytes, off_t offset)
+{
+    const char* p = static_cast<const char*>(data);
+    while (bytes > 0) {
+        const ssize_t n = pwrite(fd, p, bytes, offset);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        bytes -= n;
+        offset += n;
+    }
+    return true;
+}
+
+// copy a (text) trace into a binary trace file, one chunk at a time
+bool spillTrace(TraceReader& reader, const char* path)
+{
+    const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    BinaryTraceHeader header;
+    bool ok = true;
+    const TraceRecord *begin, *end;
+    while (ok && reader.nextChunk(begin, end)) {
+        ok = writeAll(fd, begin, (end - begin) * sizeof(TraceRecord),
+                      sizeof(header) + header.count * sizeof(TraceRecord));
+        header.count += end - begin;
+    }
+    // the header goes last, once the count is known
+    ok = ok && writeAll(fd, &header, sizeof(header), 0);
+    return close(fd) == 0 && ok;
+}
+
+}
+
+/*
+  annotateNextReferences: the next-reference pre-pass
+*/
+int64_t annotateNextReferences(const char* tracePath, const char* outPath, size_t chunkRecords)
+{
+    std::unique_ptr<TraceReader> reader = TraceReader::open(tracePath);
+    if (reader == nullptr) {
+        return -1;
+    }
+    if (dynamic_cast<MmapTraceReader*>(reader.get()) == nullptr) {
+        // spill a text trace into a binary file next to the output and map that,
+        // rather than decoding it into memory
+        const std::string spillPath = std::string(outPath) + ".spill";
+        const bool spilled = spillTrace(*reader, spillPath.c_str());
+        reader.reset(spilled ? new MmapTraceReader(spillPath.c_str()) : nullptr);
+        // the mapping outlives the file
+        unlink(spillPath.c_str());
+        if (reader == nullptr || !static_cast<MmapTraceReader*>(reader.get())->good()) {
+            std::cerr << "cannot write spill file: " << spillPath << std::endl;
+            return -1;
+        }
+    }
+    const MmapTraceReader* trace = static_cast<const MmapTraceReader*>(reader.get());
+    const int fd = ::open(outPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "cannot open next-reference file: " << outPath << std::endl;
+        return -1;
+    }
+    NextReferenceHeader header;
+    header.count = trace->count();
+    bool ok = writeAll(fd, &header, sizeof(header), 0);
+
+    // most recent index of each object seen so far (i.e., later in the trace)
+    FlatTable<LastReference> last;
+    std::vector<uint64_t> chunk(chunkRecords > 0 ? chunkRecords : 1);
+    const TraceRecord* records = trace->records();
+    uint64_t hi = trace->count();
+    while (ok && hi > 0) {
+        const uint64_t lo = hi > chunk.size() ? hi - chunk.size() : 0;
+        for (uint64_t i = hi; i-- > lo; ) {
+            const TraceRecord& rec = records[i];
+            const uint64_t h = FlatTable<LastReference>::hash(rec.id, rec.size);
+            uint32_t slot = last.find(rec.id, rec.size, h);
+            if (slot == FLAT_NPOS) {
+                chunk[i - lo] = NEXT_NEVER;
+                slot = last.insert(rec.id, rec.size, h, [](const std::vector<uint32_t>&) {});
+            } else {
+                chunk[i - lo] = last[slot].index;
+            }
+            last[slot].index = i;
+        }
+        ok = writeAll(fd, chunk.data(), (hi - lo) * sizeof(uint64_t),
+                      sizeof(header) + lo * sizeof(uint64_t));
+        hi = lo;
+    }
+    if (close(fd) != 0 || !ok) {
+        std::cerr << "cannot write next-reference file: " << outPath << std::endl;
+        return -1;
+    }
+    return trace->count();
+}
+
+/*
+  NextReferenceReader: streams a next-reference file front to back
+*/
+bool NextReferenceReader::open(const char* path)
+{
+    close();
+    _file = fopen(path, "rb");
+    if (_file == nullptr) {
+        std::cerr << "cannot open next-reference file: " << path << std::endl;
+        return false;
+    }
+    NextReferenceHeader header;
+    if (fread(&header, sizeof(header), 1, _file) != 1 || !header.hasMagic()) {
+        std::cerr << "not a next-reference file: " << path << std::endl;
+        close();
+        return false;
+    }
+    _count = header.count;
+    _read = 0;
+    _buffer.clear();
+    _pos = 0;
+    return true;
+}
+
+void NextReferenceReader::close()
+{
+    if (_file != nullptr) {
+        fclose(_file);
+        _file = nullptr;
+    }
+}
+
+bool NextReferenceReader::refill()
+{
+    if (_file == nullptr || _read == _count) {
+        return false;
+    }
+    const uint64_t n = std::min<uint64_t>(NEXT_READ_ENTRIES, _count - _read);
+    _buffer.resize(n);
+    _buffer.resize(fread(_buffer.data(), sizeof(uint64_t), n, _file));
+    _read += _buffer.size();
+    _pos = 0;
+    if (_buffer.empty()) {
+        // truncated file
+        _read = _count;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,97 @@
+#ifndef NEXT_REFERENCE_H
+#define NEXT_REFERENCE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// next reference of a request whose object is never requested again
+static const uint64_t NEXT_NEVER = UINT64_MAX;
+
+// magic string at the start of every next-reference file
+static const char NEXT_REFERENCE_MAGIC[8] = {'W', 'C', 'S', 'N', 'E', 'X', 'T', '1'};
+
+/*
+  Next-reference file format
+
+  A header followed by one uint64_t per trace request: the index of the
+  next request to the same object (id and size), or NEXT_NEVER.
+*/
+struct NextReferenceHeader
+{
+    char magic[8];
+    uint64_t count; // number of entries following the header
+
+    NextReferenceHeader()
+        : count(0)
+    {
+        std::memcpy(magic, NEXT_REFERENCE_MAGIC, sizeof(magic));
+    }
+
+    bool hasMagic() const {
+        return std::memcmp(magic, NEXT_REFERENCE_MAGIC, sizeof(magic)) == 0;
+    }
+};
+
+/*
+  annotateNextReferences: the next-reference pre-pass
+
+  Scans the trace backwards in chunks of chunkRecords requests. Each chunk's
+  next references are computed into a buffer of chunkRecords entries and
+  written to their place in the output file before the next chunk is
+  scanned, so the annotation itself never has to fit in memory. The scan
+  keeps one table entry per distinct object (its most recent index seen).
+  Binary traces are read in place via their mapping; text traces are first
+  copied chunk by chunk into a temporary binary file (outPath.spill), which
+  is mapped instead. Returns the number of requests, or -1 on error.
+*/
+int64_t annotateNextReferences(const char* tracePath, const char* outPath,
+                               size_t chunkRecords = 1 << 20);
+
+/*
+  NextReferenceReader: streams a next-reference file front to back
+*/
+class NextReferenceReader
+{
+protected:
+    FILE* _file;
+    std::vector<uint64_t> _buffer;
+    size_t _pos;
+    uint64_t _count;
+    uint64_t _read;
+
+    bool refill();
+
+public:
+    NextReferenceReader()
+        : _file(nullptr),
+          _pos(0),
+          _count(0),
+          _read(0)
+    {
+    }
+    ~NextReferenceReader() {
+        close();
+    }
+
+    // returns false if path is not a next-reference file
+    bool open(const char* path);
+    void close();
+    bool good() const {
+        return _file != nullptr;
+    }
+
+    // next reference of the following request, NEXT_NEVER past the end
+    uint64_t next() {
+        if (_pos == _buffer.size() && !refill()) {
+            return NEXT_NEVER;
+        }
+        return _buffer[_pos++];
+    }
+    uint64_t count() const {
+        return _count;
+    }
+};
+
+#endif /* NEXT_REFERENCE_H */
@@ -0,0 +1,43 @@
+#include <string>
+#include <regex>
+#include <iostream>
+#include "next_reference.h"
+
+using namespace std;
+
+int main (int argc, char* argv[])
+{
+
+  // output help if insufficient params
+  if(argc < 3) {
+    cerr << "nextref traceFile outFile [chunk=requestsPerChunk]" << endl;
+    return 1;
+  }
+
+  // parse params
+  size_t chunk = 1 << 20;
+  regex opexp ("(.*)=(.*)");
+  cmatch opmatch;
+  for(int i=3; i<argc; i++) {
+    regex_match (argv[i],opmatch,opexp);
+    if(opmatch.size()!=3) {
+      cerr << "each param needs to be in form name=value" << endl;
+      return 1;
+    }
+    const string parName = opmatch[1], parValue = opmatch[2];
+    if(parName=="chunk") {
+      chunk = stoull(parValue);
+    } else {
+      cerr << "unrecognized parameter: " << parName << endl;
+      return 1;
+    }
+  }
+
+  const int64_t count = annotateNextReferences(argv[1], argv[2], chunk);
+  if(count < 0)
+    return 1;
+
+  cout << argv[2] << " " << count << endl;
+
+  return 0;
+}
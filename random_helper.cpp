@@ -1,7 +1,7 @@
 #include <random>
 #include "random_helper.h"
 
-std::mt19937_64 globalGenerator;
+thread_local std::mt19937_64 globalGenerator;
 
 void seedGenerator()
 {
@@ -3,7 +3,9 @@
 
 #include <random>
 
-extern std::mt19937_64 globalGenerator;
+// one generator per thread, so that concurrent simulations neither race nor
+// disturb each other's random sequences
+extern thread_local std::mt19937_64 globalGenerator;
 
 void seedGenerator();
 
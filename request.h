@@ -12,26 +12,29 @@ class SimpleRequest
 private:
     IdType _id; // request object id
     uint64_t _size; // request size in bytes
+    uint64_t _time; // request time (the trace's time column)
+    uint64_t _ttl; // time-to-live of the object, 0 if none is given
 
 public:
     SimpleRequest()
     {
     }
-    virtual ~SimpleRequest()
-    {
-    }
 
     // Create request
-    SimpleRequest(IdType id, uint64_t size)
+    SimpleRequest(IdType id, uint64_t size, uint64_t time = 0, uint64_t ttl = 0)
         : _id(id),
-          _size(size)
+          _size(size),
+          _time(time),
+          _ttl(ttl)
     {
     }
 
-    void reinit(IdType id, uint64_t size)
+    void reinit(IdType id, uint64_t size, uint64_t time = 0, uint64_t ttl = 0)
     {
         _id = id;
         _size = size;
+        _time = time;
+        _ttl = ttl;
     }
 
 
@@ -52,6 +55,18 @@ public:
     {
         return _size;
     }
+
+    // Get request time
+    uint64_t getTime() const
+    {
+        return _time;
+    }
+
+    // Get the object's time-to-live, 0 if none
+    uint64_t getTtl() const
+    {
+        return _ttl;
+    }
 };
 
 
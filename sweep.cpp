@@ -0,0 +1,211 @@
+#include <string>
+#include <regex>
+#include <sstream>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "caches/lru_variants.h"
+#include "caches/gd_variants.h"
+#include "random_helper.h"
+#include "request.h"
+#include "trace_reader.h"
+
+using namespace std;
+
+// one simulation: a policy, a cache size, and a parameter set
+struct Configuration {
+  string cacheType;
+  uint64_t cacheSize;
+  vector<pair<string, string> > params;
+
+  // results
+  long long reqs = 0, hits = 0;
+  long long bytes = 0, hitBytes = 0;
+  double seconds = 0;
+};
+
+/*
+  WorkStealingPool: runs tasks 0..n-1 on a fixed number of threads
+
+  Tasks are dealt round-robin into per-thread deques. A thread works off
+  the front of its own deque and, once that is empty, steals from the
+  back of the others'.
+*/
+class WorkStealingPool {
+protected:
+  struct Queue {
+    mutex lock;
+    deque<size_t> tasks;
+  };
+  vector<Queue> _queues;
+
+  bool pop(size_t self, size_t& task) {
+    {
+      lock_guard<mutex> guard(_queues[self].lock);
+      if(!_queues[self].tasks.empty()) {
+        task = _queues[self].tasks.front();
+        _queues[self].tasks.pop_front();
+        return true;
+      }
+    }
+    for(size_t i=1; i<_queues.size(); i++) {
+      Queue& victim = _queues[(self + i) % _queues.size()];
+      lock_guard<mutex> guard(victim.lock);
+      if(!victim.tasks.empty()) {
+        task = victim.tasks.back();
+        victim.tasks.pop_back();
+        return true;
+      }
+    }
+    return false;
+  }
+
+public:
+  WorkStealingPool(size_t threads)
+    : _queues(threads)
+  {
+  }
+
+  template<class F> void run(size_t n, F work) {
+    for(size_t i=0; i<n; i++)
+      _queues[i % _queues.size()].tasks.push_back(i);
+    vector<thread> threads;
+    for(size_t t=0; t<_queues.size(); t++) {
+      threads.emplace_back([this, t, &work]() {
+          size_t task;
+          while(pop(t, task))
+            work(task);
+        });
+    }
+    for(auto& th : threads)
+      th.join();
+  }
+};
+
+// replay the shared trace through one configuration
+static void simulate(const LoadedTrace& trace, Configuration& conf)
+{
+  unique_ptr<ReplayEngine> engine = Cache::create_engine(conf.cacheType);
+  Cache& webcache = engine->cache();
+  webcache.setSize(conf.cacheSize);
+  for(auto& par : conf.params)
+    webcache.configure(par.first, par.second);
+  // same random sequence as a fresh webcachesim run
+  globalGenerator.seed(mt19937_64::default_seed);
+
+  const auto start = chrono::steady_clock::now();
+  ReplayStats stats;
+  engine->replay(trace.begin(), trace.end(), stats);
+  conf.reqs = stats.reqs;
+  conf.hits = stats.hits;
+  conf.bytes = stats.bytes;
+  conf.hitBytes = stats.hitBytes;
+  conf.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static vector<string> split(const string& s, char delim)
+{
+  vector<string> parts;
+  stringstream ss(s);
+  string part;
+  while(getline(ss, part, delim))
+    parts.push_back(part);
+  return parts;
+}
+
+int main (int argc, char* argv[])
+{
+
+  // output help if insufficient params
+  if(argc < 4) {
+    cerr << "sweep traceFile cacheType1,cacheType2,... cacheSize1,cacheSize2,... [threads=n] [[cacheType:]name=value,name=value...]..." << endl;
+    return 1;
+  }
+
+  // trace properties
+  const char* path = argv[1];
+  const vector<string> cacheTypes = split(argv[2], ',');
+  vector<uint64_t> cacheSizes;
+  for(auto& size : split(argv[3], ','))
+    cacheSizes.push_back(stoull(size));
+  for(auto& cacheType : cacheTypes)
+    if(Cache::create_unique(cacheType) == nullptr)
+      return 1;
+
+  // parse parameter sets, each optionally restricted to one policy
+  size_t threads = max(1u, thread::hardware_concurrency());
+  vector<pair<string, vector<pair<string, string> > > > paramSets;
+  regex opexp ("(.*)=(.*)");
+  smatch opmatch;
+  for(int i=4; i<argc; i++) {
+    string arg = argv[i];
+    if(arg.compare(0, 8, "threads=") == 0) {
+      threads = max(1ULL, stoull(arg.substr(8)));
+      continue;
+    }
+    string cacheType;
+    const size_t colon = arg.find(':');
+    if(colon != string::npos) {
+      cacheType = arg.substr(0, colon);
+      arg = arg.substr(colon + 1);
+    }
+    vector<pair<string, string> > params;
+    for(auto& par : split(arg, ',')) {
+      regex_match (par,opmatch,opexp);
+      if(opmatch.size()!=3) {
+        cerr << "each cacheParam needs to be in form name=value" << endl;
+        return 1;
+      }
+      params.push_back(make_pair(opmatch[1], opmatch[2]));
+    }
+    paramSets.push_back(make_pair(cacheType, params));
+  }
+
+  // cross product of policies, sizes, and applicable parameter sets
+  vector<Configuration> confs;
+  for(auto& cacheType : cacheTypes) {
+    vector<vector<pair<string, string> > > sets;
+    for(auto& paramSet : paramSets)
+      if(paramSet.first.empty() || paramSet.first == cacheType)
+        sets.push_back(paramSet.second);
+    if(sets.empty())
+      sets.push_back(vector<pair<string, string> >());
+    for(auto size : cacheSizes) {
+      for(auto& params : sets) {
+        Configuration conf;
+        conf.cacheType = cacheType;
+        conf.cacheSize = size;
+        conf.params = params;
+        confs.push_back(conf);
+      }
+    }
+  }
+
+  // decode the trace once, all simulations share it read-only
+  unique_ptr<LoadedTrace> trace = LoadedTrace::load(path);
+  if(trace == nullptr)
+    return 1;
+
+  cerr << "running " << confs.size() << " configurations on " << threads << " threads..." << endl;
+
+  WorkStealingPool pool(threads);
+  pool.run(confs.size(), [&](size_t i) {
+      simulate(*trace, confs[i]);
+    });
+
+  // one row per configuration
+  for(auto& conf : confs) {
+    string paramSummary;
+    for(auto& par : conf.params)
+      paramSummary += (paramSummary.empty() ? "" : ",") + par.first + "=" + par.second;
+    cout << conf.cacheType << " " << conf.cacheSize << " "
+         << (paramSummary.empty() ? "-" : paramSummary) << " "
+         << conf.reqs << " " << conf.hits << " "
+         << double(conf.hits)/conf.reqs << " "
+         << double(conf.hitBytes)/conf.bytes << " "
+         << conf.seconds << endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,163 @@
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "trace_reader.h"
+
+// number of text lines parsed per chunk
+static const size_t TEXT_CHUNK_RECORDS = 4096;
+
+std::unique_ptr<TraceReader> TraceReader::open(const char* path)
+{
+    // sniff the header to tell binary from text traces
+    BinaryTraceHeader header;
+    bool binary = false;
+    {
+        std::ifstream probe(path, std::ios::binary);
+        if (!probe.is_open()) {
+            std::cerr << "cannot open trace: " << path << std::endl;
+            return nullptr;
+        }
+        if (probe.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            binary = header.hasMagic();
+        }
+    }
+
+    if (binary) {
+        std::unique_ptr<MmapTraceReader> reader(new MmapTraceReader(path));
+        if (!reader->good()) {
+            return nullptr;
+        }
+        return std::move(reader);
+    }
+    std::unique_ptr<TextTraceReader> reader(new TextTraceReader(path));
+    if (!reader->good()) {
+        std::cerr << "cannot open trace: " << path << std::endl;
+        return nullptr;
+    }
+    return std::move(reader);
+}
+
+/*
+  TextTraceReader: space-separated "time id size [ttl]" lines
+*/
+TextTraceReader::TextTraceReader(const char* path)
+    : TraceReader(),
+      _infile(path)
+{
+    _buffer.reserve(TEXT_CHUNK_RECORDS);
+}
+
+bool TextTraceReader::refill()
+{
+    _buffer.clear();
+    TraceRecord rec;
+    while (_buffer.size() < TEXT_CHUNK_RECORDS && std::getline(_infile, _line)) {
+        if (_line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        if (!parseTraceLine(_line.c_str(), rec)) {
+            // stop at the first malformed line
+            _infile.setstate(std::ios::failbit);
+            break;
+        }
+        _buffer.push_back(rec);
+    }
+    _pos = _buffer.data();
+    _end = _pos + _buffer.size();
+    return _pos != _end;
+}
+
+/*
+  MmapTraceReader: zero-copy reader for binary traces
+*/
+MmapTraceReader::MmapTraceReader(const char* path)
+    : TraceReader(),
+      _map(MAP_FAILED),
+      _mapSize(0),
+      _records(nullptr),
+      _count(0),
+      _consumed(false)
+{
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "cannot open trace: " << path << std::endl;
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(BinaryTraceHeader)) {
+        std::cerr << "truncated binary trace: " << path << std::endl;
+        close(fd);
+        return;
+    }
+    _mapSize = st.st_size;
+    _map = mmap(nullptr, _mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (_map == MAP_FAILED) {
+        std::cerr << "cannot mmap trace: " << path << std::endl;
+        return;
+    }
+    // records are consumed front to back
+    madvise(_map, _mapSize, MADV_SEQUENTIAL);
+
+    const BinaryTraceHeader* header = static_cast<const BinaryTraceHeader*>(_map);
+    if (!header->hasMagic() || header->version != BINARY_TRACE_VERSION
+        || header->recordSize != sizeof(TraceRecord)) {
+        std::cerr << "unsupported binary trace version " << header->version
+                  << " (expected " << BINARY_TRACE_VERSION << "): " << path << std::endl;
+        return;
+    }
+    if (header->count > (_mapSize - sizeof(BinaryTraceHeader)) / sizeof(TraceRecord)) {
+        std::cerr << "truncated binary trace: " << path << std::endl;
+        return;
+    }
+    _count = header->count;
+    _records = reinterpret_cast<const TraceRecord*>(static_cast<const char*>(_map) + sizeof(BinaryTraceHeader));
+}
+
+MmapTraceReader::~MmapTraceReader()
+{
+    if (_map != MAP_FAILED) {
+        munmap(_map, _mapSize);
+    }
+}
+
+bool MmapTraceReader::refill()
+{
+    // the mapping is a single chunk
+    if (_consumed || _records == nullptr) {
+        return false;
+    }
+    _consumed = true;
+    _pos = _records;
+    _end = _records + _count;
+    return _pos != _end;
+}
+
+/*
+  LoadedTrace: a whole trace in memory, shared read-only between threads
+*/
+std::unique_ptr<LoadedTrace> LoadedTrace::load(const char* path)
+{
+    std::unique_ptr<LoadedTrace> trace(new LoadedTrace());
+    trace->_reader = TraceReader::open(path);
+    if (trace->_reader == nullptr) {
+        return nullptr;
+    }
+    MmapTraceReader* mapped = dynamic_cast<MmapTraceReader*>(trace->_reader.get());
+    if (mapped != nullptr) {
+        // use the mapping in place
+        trace->_records = mapped->records();
+        trace->_count = mapped->count();
+        return trace;
+    }
+    const TraceRecord *begin, *end;
+    while (trace->_reader->nextChunk(begin, end)) {
+        trace->_decoded.insert(trace->_decoded.end(), begin, end);
+    }
+    trace->_reader.reset();
+    trace->_records = trace->_decoded.data();
+    trace->_count = trace->_decoded.size();
+    return trace;
+}
@@ -0,0 +1,150 @@
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "binary_trace.h"
+#include "request.h"
+
+/*
+  TraceReader: sequential access to a request trace
+
+  Requests are handed out in chunks of TraceRecords. Binary traces are
+  memory-mapped and the chunk points directly into the mapping (no copy),
+  text traces are parsed into an internal buffer one chunk at a time.
+*/
+class TraceReader
+{
+protected:
+    // current chunk
+    const TraceRecord* _pos;
+    const TraceRecord* _end;
+
+    // load the next chunk into [_pos, _end), returns false at end of trace
+    virtual bool refill() = 0;
+
+public:
+    TraceReader()
+        : _pos(nullptr),
+          _end(nullptr)
+    {
+    }
+    virtual ~TraceReader()
+    {
+    }
+
+    // read next request, returns false at end of trace
+    bool next(SimpleRequest* req) {
+        if (_pos == _end && !refill()) {
+            return false;
+        }
+        req->reinit(_pos->id, _pos->size, _pos->time, _pos->ttl);
+        ++_pos;
+        return true;
+    }
+
+    // get the remainder of the current chunk (or the next one), returns false at end of trace
+    bool nextChunk(const TraceRecord*& begin, const TraceRecord*& end) {
+        if (_pos == _end && !refill()) {
+            return false;
+        }
+        begin = _pos;
+        end = _end;
+        _pos = _end;
+        return true;
+    }
+
+    // open a text or binary trace (detected via the binary header's magic)
+    static std::unique_ptr<TraceReader> open(const char* path);
+};
+
+/*
+  TextTraceReader: space-separated "time id size [ttl]" lines
+*/
+class TextTraceReader : public TraceReader
+{
+protected:
+    std::ifstream _infile;
+    std::string _line;
+    std::vector<TraceRecord> _buffer;
+
+    virtual bool refill();
+
+public:
+    TextTraceReader(const char* path);
+    virtual ~TextTraceReader()
+    {
+    }
+
+    bool good() const {
+        return _infile.is_open();
+    }
+};
+
+/*
+  MmapTraceReader: zero-copy reader for binary traces
+*/
+class MmapTraceReader : public TraceReader
+{
+protected:
+    void* _map;
+    size_t _mapSize;
+    const TraceRecord* _records;
+    uint64_t _count;
+    bool _consumed;
+
+    virtual bool refill();
+
+public:
+    MmapTraceReader(const char* path);
+    virtual ~MmapTraceReader();
+
+    bool good() const {
+        return _records != nullptr;
+    }
+
+    // the whole trace as a flat array
+    const TraceRecord* records() const {
+        return _records;
+    }
+    uint64_t count() const {
+        return _count;
+    }
+};
+
+/*
+  LoadedTrace: a whole trace in memory, shared read-only between threads
+
+  Binary traces stay memory-mapped, text traces are decoded once.
+*/
+class LoadedTrace
+{
+protected:
+    std::unique_ptr<TraceReader> _reader;
+    std::vector<TraceRecord> _decoded;
+    const TraceRecord* _records;
+    uint64_t _count;
+
+    LoadedTrace()
+        : _records(nullptr),
+          _count(0)
+    {
+    }
+
+public:
+    static std::unique_ptr<LoadedTrace> load(const char* path);
+
+    const TraceRecord* begin() const {
+        return _records;
+    }
+    const TraceRecord* end() const {
+        return _records + _count;
+    }
+    uint64_t size() const {
+        return _count;
+    }
+};
+
+#endif /* TRACE_READER_H */
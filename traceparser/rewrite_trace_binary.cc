@@ -0,0 +1,70 @@
+#include <fstream>
+#include <string>
+#include <vector>
+#include <iostream>
+#include "../binary_trace.h"
+
+using namespace std;
+
+// rewrite a text trace ("time id size [ttl]" per line) into the binary trace format
+int main (int argc, char* argv[])
+{
+
+  // parameters
+  if(argc != 3) {
+    cerr << "rewrite_trace_binary textTrace binaryTrace" << endl;
+    return 1;
+  }
+
+  const char* inputFile = argv[1];
+  const char* outputFile = argv[2];
+
+  cout << "running..." << endl;
+
+  ifstream infile(inputFile);
+  if(!infile.is_open()) {
+    cerr << "cannot open " << inputFile << endl;
+    return 1;
+  }
+  ofstream outfile(outputFile, ios::binary | ios::trunc);
+  if(!outfile.is_open()) {
+    cerr << "cannot open " << outputFile << endl;
+    return 1;
+  }
+
+  // header is rewritten with the final count at the end
+  BinaryTraceHeader header;
+  outfile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  const size_t chunk = 65536;
+  vector<TraceRecord> buffer;
+  buffer.reserve(chunk);
+  string line;
+  TraceRecord rec;
+  while (getline(infile, line)) {
+    if(line.find_first_not_of(" \t\r") == string::npos)
+      continue;
+    if(!parseTraceLine(line.c_str(), rec))
+      break;
+    buffer.push_back(rec);
+    if(buffer.size() == chunk) {
+      outfile.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(TraceRecord));
+      header.count += buffer.size();
+      buffer.clear();
+    }
+  }
+  outfile.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(TraceRecord));
+  header.count += buffer.size();
+
+  outfile.seekp(0);
+  outfile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  outfile.close();
+  if(!outfile) {
+    cerr << "error writing " << outputFile << endl;
+    return 1;
+  }
+
+  cout << "rewrote " << header.count << " requests" << endl;
+
+  return 0;
+}
@@ -1,35 +1,131 @@
-#include <fstream>
 #include <string>
 #include <regex>
+#include <sstream>
 #include "caches/lru_variants.h"
 #include "caches/gd_variants.h"
+#include "flash/flash_device.h"
+#include "cache_hierarchy.h"
+#include "analysis/window_metrics.h"
 #include "request.h"
+#include "trace_reader.h"
 
 using namespace std;
 
+// flash device columns: bytes admitted, written by the cache, written to
+// flash, write amplification, flash bytes per hit, GC relocations, erases
+static void printDevice(const FlashDevice& device, uint64_t hits)
+{
+  const DeviceStats& ds = device.stats();
+  cout << " " << ds.admittedBytes << " " << ds.hostBytes << " " << ds.nandBytes << " "
+       << (ds.admittedBytes > 0 ? double(ds.nandBytes)/ds.admittedBytes : 0) << " "
+       << (hits > 0 ? double(ds.nandBytes)/hits : 0) << " "
+       << ds.relocatedBytes + ds.ftlRelocatedBytes << " " << ds.droppedBytes << " "
+       << ds.erasedBlocks;
+}
+
+// cacheType1+cacheType2+... with cacheSize1,cacheSize2,...: a hierarchy
+static int simulateHierarchy(int argc, char* argv[])
+{
+  const char* path = argv[1];
+
+  // create one tier per cache type and size
+  CacheHierarchy hierarchy;
+  stringstream types(argv[2]), sizes(argv[3]);
+  string cacheType, cacheSize;
+  while(getline(types, cacheType, '+')) {
+    if(!getline(sizes, cacheSize, ',')) {
+      cerr << "each tier needs a cacheSize" << endl;
+      return 1;
+    }
+    if(!hierarchy.addTier(cacheType, std::stoull(cacheSize)))
+      return 1;
+  }
+
+  // parse hierarchy and cache parameters
+  regex opexp ("(.*)=(.*)");
+  cmatch opmatch;
+  string paramSummary;
+  for(int i=4; i<argc; i++) {
+    regex_match (argv[i],opmatch,opexp);
+    if(opmatch.size()!=3) {
+      cerr << "each cacheParam needs to be in form name=value" << endl;
+      return 1;
+    }
+    // time series are not split by tier
+    if(WindowMetrics::isPar(opmatch[1])) {
+      cerr << "metrics parameters are not supported with cache hierarchies: " << opmatch[1] << endl;
+      return 1;
+    }
+    hierarchy.configure(opmatch[1], opmatch[2]);
+    paramSummary += opmatch[2];
+  }
+  if(!hierarchy.open())
+    return 1;
+
+  // open text or binary trace
+  unique_ptr<TraceReader> trace = TraceReader::open(path);
+  if(trace == nullptr)
+    return 1;
+
+  ReplayStats stats;
+
+  cerr << "running..." << endl;
+
+  const TraceRecord *begin, *end;
+  while (trace->nextChunk(begin, end))
+    hierarchy.replay(begin, end, stats);
+
+  cout << argv[2] << " " << argv[3] << " " << paramSummary << " "
+       << stats.reqs << " " << stats.hits << " "
+       << double(stats.hits)/stats.reqs << endl;
+  // per tier: requests reaching it, hits, local hit ratio, bytes admitted by
+  // fills, promotions and demotions, bytes evicted (and its flash device)
+  for(unsigned l = 0; l < hierarchy.tiers(); l++) {
+    const TierStats& ts = hierarchy.stats(l);
+    cout << "tier" << l + 1 << " " << hierarchy.type(l) << " " << hierarchy.size(l) << " "
+         << ts.reqs << " " << ts.hits << " "
+         << (ts.reqs > 0 ? double(ts.hits)/ts.reqs : 0) << " "
+         << ts.fillBytes << " " << ts.promotedBytes << " " << ts.demotedBytes << " "
+         << ts.evictedBytes;
+    if(hierarchy.device(l).enabled())
+      printDevice(hierarchy.device(l), ts.hits);
+    cout << endl;
+  }
+
+  return 0;
+}
+
 int main (int argc, char* argv[])
 {
 
   // output help if insufficient params
   if(argc < 4) {
     cerr << "webcachesim traceFile cacheType cacheSizeBytes [cacheParams]" << endl;
+    cerr << "webcachesim traceFile cacheType1+cacheType2+... cacheSize1,cacheSize2,... [cacheParams]" << endl;
     return 1;
   }
 
+  if(string(argv[2]).find('+') != string::npos)
+    return simulateHierarchy(argc, argv);
+
   // trace properties
   const char* path = argv[1];
 
   // create cache
   const string cacheType = argv[2];
-  unique_ptr<Cache> webcache = move(Cache::create_unique(cacheType));
-  if(webcache == nullptr)
+  unique_ptr<ReplayEngine> engine = Cache::create_engine(cacheType);
+  if(engine == nullptr)
     return 1;
+  Cache& webcache = engine->cache();
 
   // configure cache size
   const uint64_t cache_size  = std::stoull(argv[3]);
-  webcache->setSize(cache_size);
+  webcache.setSize(cache_size);
 
-  // parse cache parameters
+  // parse cache parameters, device parameters select a simulated flash device,
+  // metrics parameters a time series of the replay
+  FlashDevice device;
+  WindowMetrics metrics;
   regex opexp ("(.*)=(.*)");
   cmatch opmatch;
   string paramSummary;
@@ -39,36 +135,56 @@ int main (int argc, char* argv[])
       cerr << "each cacheParam needs to be in form name=value" << endl;
       return 1;
     }
-    webcache->setPar(opmatch[1], opmatch[2]);
+    if(!device.setPar(opmatch[1], opmatch[2]) && !metrics.setPar(opmatch[1], opmatch[2]))
+      webcache.configure(opmatch[1], opmatch[2]);
     paramSummary += opmatch[2];
   }
+  if(!device.valid())
+    return 1;
+  // the cache size is the device size, the policy gets its usable part
+  if(device.enabled() && !device.attach(webcache, cache_size))
+    return 1;
+  if(!metrics.open())
+    return 1;
 
-  ifstream infile;
-  long long reqs = 0, hits = 0;
-  long long t, id, size;
+  // open text or binary trace
+  unique_ptr<TraceReader> trace = TraceReader::open(path);
+  if(trace == nullptr)
+    return 1;
 
-  cerr << "running..." << endl;
+  ReplayStats stats;
 
-  infile.open(path);
-  SimpleRequest* req = new SimpleRequest(0, 0);
-  while (infile >> t >> id >> size)
-    {
-        reqs++;
-        
-        req->reinit(id,size);
-        if(webcache->lookup(req)) {
-            hits++;
-        } else {
-            webcache->admit(req);
-        }
-    }
+  cerr << "running..." << endl;
 
-  delete req;
+  const ReplayFunction replay = [&](const TraceRecord* from, const TraceRecord* to, ReplayStats& replayed) {
+    if(device.enabled())
+      device.replay(from, to, replayed);
+    else
+      engine->replay(from, to, replayed);
+  };
+  const TraceRecord *begin, *end;
+  while (trace->nextChunk(begin, end)) {
+    if(metrics.enabled())
+      metrics.replay(begin, end, stats, webcache, replay);
+    else
+      replay(begin, end, stats);
+  }
+  // totals without the warm-up
+  if(metrics.enabled())
+    stats = metrics.finish(stats, webcache);
 
-  infile.close();
   cout << cacheType << " " << cache_size << " " << paramSummary << " "
-       << reqs << " " << hits << " "
-       << double(hits)/reqs << endl;
+       << stats.reqs << " " << stats.hits << " "
+       << double(stats.hits)/stats.reqs;
+  // with TTLs: bytes removed by expiration and by capacity evictions (after the warm-up)
+  if(webcache.hasExpiry())
+    cout << " " << metrics.expiredBytes(webcache) << " " << metrics.evictedBytes(webcache);
+  // with ghost lists (e.g., ARC): their peak memory in bytes
+  if(webcache.hasGhosts())
+    cout << " " << webcache.getGhostMemory();
+  if(device.enabled())
+    printDevice(device, stats.hits);
+  cout << endl;
 
   return 0;
 }